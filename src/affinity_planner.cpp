@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "affinity_planner.h"
+
+//Internal
+#include "global.h"
+#include "job_object.h"
+
+//Qt
+#include <QMutex>
+#include <QVector>
+#include <QtAlgorithms>
+
+//Windows includes
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+/*
+ * The affinity planner gives each running job a disjoint set of physical cores. The cores are ordered by
+ * NUMA node first and by L3 cache (CCX) second, so that a contiguous range of cores stays as local as
+ * possible; the logical processors (SMT siblings) of a core are always kept together. The affinity is set
+ * on the job object, so it applies to the encoder as well as to the source process. Whenever a job starts
+ * or finishes, the cores are re-distributed among the jobs that are still running. If there are more jobs
+ * than cores, no disjoint assignment exists and all restrictions are lifted. A job object affinity mask can
+ * only address a single processor group, so the planner is turned off on systems with more than one group
+ * (i.e. more than 64 logical processors); pinning all jobs to one group would be worse than not planning.
+ */
+
+typedef struct
+{
+	quint64 mask;
+	int numaNode;
+	int cacheL3;
+}
+core_t;
+
+//GetLogicalProcessorInformationEx() requires Windows 7, so it must not be imported statically
+typedef BOOL (WINAPI *GetLogicalProcessorInformationExFun)(LOGICAL_PROCESSOR_RELATIONSHIP, PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, PDWORD);
+
+static bool lessThanCore(const core_t &a, const core_t &b)
+{
+	if(a.numaNode != b.numaNode) return a.numaNode < b.numaNode;
+	if(a.cacheL3  != b.cacheL3)  return a.cacheL3  < b.cacheL3;
+	return a.mask < b.mask;
+}
+
+static int findGroup(const QList<quint64> &groups, const quint64 &mask)
+{
+	for(int i = 0; i < groups.count(); i++)
+	{
+		if(groups.at(i) & mask)
+		{
+			return i;
+		}
+	}
+	return groups.count();
+}
+
+static QMutex g_affinityPlannerMutex;
+static QList<JobObject*> g_affinityPlannerJobs;
+
+///////////////////////////////////////////////////////////////////////////////
+// Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+void AffinityPlanner::addJob(JobObject *const jobObject)
+{
+	QMutexLocker lock(&g_affinityPlannerMutex);
+	if(jobObject && (!g_affinityPlannerJobs.contains(jobObject)))
+	{
+		g_affinityPlannerJobs.append(jobObject);
+		rebalance();
+	}
+}
+
+void AffinityPlanner::removeJob(JobObject *const jobObject)
+{
+	QMutexLocker lock(&g_affinityPlannerMutex);
+	if(jobObject && g_affinityPlannerJobs.removeAll(jobObject))
+	{
+		jobObject->setAffinity(0);
+		rebalance();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+void AffinityPlanner::rebalance(void)
+{
+	const QList<quint64> &cores = getCores();
+	const int jobCount = g_affinityPlannerJobs.count(), coreCount = cores.count();
+
+	//A single job may use the whole machine, too many jobs can not be separated
+	if((jobCount < 2) || (jobCount > coreCount))
+	{
+		for(QList<JobObject*>::ConstIterator iter = g_affinityPlannerJobs.constBegin(); iter != g_affinityPlannerJobs.constEnd(); iter++)
+		{
+			(*iter)->setAffinity(0);
+		}
+		return;
+	}
+
+	//Assign contiguous ranges of cores, the remainder is spread over the first jobs
+	int nextCore = 0;
+	for(int i = 0; i < jobCount; i++)
+	{
+		const int count = (coreCount / jobCount) + ((i < (coreCount % jobCount)) ? 1 : 0);
+		quint64 mask = 0;
+		for(int j = 0; j < count; j++)
+		{
+			mask |= cores.at(nextCore++);
+		}
+		qDebug("Affinity of job #%d set to 0x%016llX (%d cores).", i, mask, count);
+		g_affinityPlannerJobs.at(i)->setAffinity(mask);
+	}
+}
+
+const QList<quint64> &AffinityPlanner::getCores(void)
+{
+	static QList<quint64> cores;
+	static bool detected = false;
+	if(!detected)
+	{
+		detectCores(cores);
+		detected = true;
+	}
+	return cores;
+}
+
+void AffinityPlanner::detectCores(QList<quint64> &cores)
+{
+	DWORD_PTR processMask = 0, systemMask = 0;
+	if(!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+	{
+		qWarning("[AffinityPlanner] Failed to get the process affinity mask!");
+		processMask = 1;
+	}
+
+	QList<quint64> cpuCores, numaNodes, cachesL3;
+	WORD groupCount = 1;
+	DWORD bufferSize = 0;
+	const GetLogicalProcessorInformationExFun getProcessorInfo = reinterpret_cast<GetLogicalProcessorInformationExFun>(GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "GetLogicalProcessorInformationEx"));
+	if(!getProcessorInfo)
+	{
+		qWarning("[AffinityPlanner] GetLogicalProcessorInformationEx() is not available!");
+	}
+	else if((!getProcessorInfo(RelationAll, NULL, &bufferSize)) && (GetLastError() == ERROR_INSUFFICIENT_BUFFER) && (bufferSize > 0))
+	{
+		QVector<BYTE> buffer(bufferSize);
+		if(getProcessorInfo(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &bufferSize))
+		{
+			for(DWORD offset = 0; offset < bufferSize;)
+			{
+				const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *const info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.constData() + offset);
+				switch(info->Relationship)
+				{
+				case RelationProcessorCore:
+					for(WORD i = 0; i < info->Processor.GroupCount; i++)
+					{
+						if(info->Processor.GroupMask[i].Group == 0) cpuCores << quint64(info->Processor.GroupMask[i].Mask);
+					}
+					break;
+				case RelationNumaNode:
+					if(info->NumaNode.GroupMask.Group == 0) numaNodes << quint64(info->NumaNode.GroupMask.Mask);
+					break;
+				case RelationCache:
+					if((info->Cache.Level == 3) && (info->Cache.GroupMask.Group == 0)) cachesL3 << quint64(info->Cache.GroupMask.Mask);
+					break;
+				case RelationGroup:
+					groupCount = info->Group.ActiveGroupCount;
+					break;
+				}
+				offset += info->Size;
+			}
+		}
+	}
+	else
+	{
+		qWarning("[AffinityPlanner] Failed to get the logical processor information!");
+	}
+
+	//The job object affinity can not span multiple processor groups, so leave the scheduling to the system
+	if(groupCount > 1)
+	{
+		qWarning("[AffinityPlanner] System has %u processor groups, affinity planner is disabled!", static_cast<unsigned int>(groupCount));
+		return;
+	}
+
+	QList<core_t> list;
+	for(QList<quint64>::ConstIterator iter = cpuCores.constBegin(); iter != cpuCores.constEnd(); iter++)
+	{
+		const quint64 mask = (*iter) & quint64(processMask);
+		if(mask)
+		{
+			const core_t core = { mask, findGroup(numaNodes, mask), findGroup(cachesL3, mask) };
+			list << core;
+		}
+	}
+
+	//Fall back to one core per logical processor, if the topology is not available
+	if(list.isEmpty())
+	{
+		for(int i = 0; i < 64; i++)
+		{
+			const quint64 mask = quint64(processMask) & (quint64(1) << i);
+			if(mask)
+			{
+				const core_t core = { mask, 0, 0 };
+				list << core;
+			}
+		}
+	}
+
+	qStableSort(list.begin(), list.end(), lessThanCore);
+	for(QList<core_t>::ConstIterator iter = list.constBegin(); iter != list.constEnd(); iter++)
+	{
+		cores << iter->mask;
+	}
+
+	qDebug("Affinity planner: %d cores, %d NUMA node(s), %d L3 cache(s).", cores.count(), numaNodes.count(), cachesL3.count());
+}
@@ -0,0 +1,228 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "binary_manifest.h"
+
+//Internal
+#include "global.h"
+
+//Qt
+#include <QStringList>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSettings>
+#include <QMutex>
+#include <QHash>
+
+/*
+ * The manifest remembers which of the tool binaries have been verified already, along with their size and
+ * time stamp, so that unchanged files can be accepted at the next start without checking them once more.
+ * It also stores the digest of a file, once it has been computed, so that the file doesn't need to be hashed
+ * again. The manifest is loaded into memory on first access and written back to the data path by save().
+ */
+
+static const char *const KEY_PATH   = "path";
+static const char *const KEY_SIZE   = "size";
+static const char *const KEY_TIME   = "time";
+static const char *const KEY_FLAGS  = "flags";
+static const char *const KEY_DIGEST = "digest";
+static const char *const KEY_FILES  = "files";
+
+typedef struct
+{
+	QString path;
+	qint64 size;
+	qint64 time;
+	int flags;
+	QByteArray digest;
+}
+manifest_entry_t;
+
+static QMutex g_manifestMutex;
+static QHash<QString, manifest_entry_t> g_manifest;
+static bool g_manifestLoaded = false;
+static bool g_manifestDirty = false;
+
+bool BinaryManifest::isVerified(const QString &filePath, const int &flag)
+{
+	QString key;
+	qint64 size = -1, time = -1;
+	if(!getFileStamp(filePath, key, size, time))
+	{
+		return false;
+	}
+
+	QMutexLocker lock(&g_manifestMutex);
+	load();
+
+	QHash<QString, manifest_entry_t>::ConstIterator iter = g_manifest.constFind(key);
+	return (iter != g_manifest.constEnd()) && (iter->size == size) && (iter->time == time) && ((iter->flags & flag) == flag);
+}
+
+void BinaryManifest::setVerified(const QString &filePath, const int &flag)
+{
+	QString key;
+	qint64 size = -1, time = -1;
+	if(!getFileStamp(filePath, key, size, time))
+	{
+		return;
+	}
+
+	QMutexLocker lock(&g_manifestMutex);
+	load();
+
+	manifest_entry_t &entry = g_manifest[key];
+	if((entry.size != size) || (entry.time != time))
+	{
+		entry.path = QDir::cleanPath(QFileInfo(filePath).absoluteFilePath());
+		entry.size = size;
+		entry.time = time;
+		entry.flags = 0;
+		entry.digest.clear();
+	}
+
+	entry.flags |= flag;
+	g_manifestDirty = true;
+}
+
+bool BinaryManifest::lookupDigest(const QString &filePath, QByteArray &digest)
+{
+	QString key;
+	qint64 size = -1, time = -1;
+	if(!getFileStamp(filePath, key, size, time))
+	{
+		return false;
+	}
+
+	QMutexLocker lock(&g_manifestMutex);
+	load();
+
+	QHash<QString, manifest_entry_t>::ConstIterator iter = g_manifest.constFind(key);
+	if((iter != g_manifest.constEnd()) && (iter->size == size) && (iter->time == time) && (!iter->digest.isEmpty()))
+	{
+		digest = iter->digest;
+		return true;
+	}
+
+	return false;
+}
+
+void BinaryManifest::insertDigest(const QString &filePath, const QByteArray &digest)
+{
+	QString key;
+	qint64 size = -1, time = -1;
+	if(!getFileStamp(filePath, key, size, time))
+	{
+		return;
+	}
+
+	QMutexLocker lock(&g_manifestMutex);
+	load();
+
+	manifest_entry_t &entry = g_manifest[key];
+	if((entry.size != size) || (entry.time != time))
+	{
+		entry.path = QDir::cleanPath(QFileInfo(filePath).absoluteFilePath());
+		entry.size = size;
+		entry.time = time;
+		entry.flags = 0;
+	}
+
+	entry.digest = digest;
+	g_manifestDirty = true;
+}
+
+void BinaryManifest::save(void)
+{
+	QMutexLocker lock(&g_manifestMutex);
+	if(!g_manifestDirty)
+	{
+		return;
+	}
+
+	QSettings settings(getManifestFile(), QSettings::IniFormat);
+	settings.clear();
+	settings.beginWriteArray(KEY_FILES, g_manifest.count());
+
+	int index = 0;
+	for(QHash<QString, manifest_entry_t>::ConstIterator iter = g_manifest.constBegin(); iter != g_manifest.constEnd(); iter++)
+	{
+		settings.setArrayIndex(index++);
+		settings.setValue(KEY_PATH,   iter->path);
+		settings.setValue(KEY_SIZE,   iter->size);
+		settings.setValue(KEY_TIME,   iter->time);
+		settings.setValue(KEY_FLAGS,  iter->flags);
+		settings.setValue(KEY_DIGEST, QString::fromLatin1(iter->digest.constData()));
+	}
+
+	settings.endArray();
+	settings.sync();
+	g_manifestDirty = false;
+}
+
+void BinaryManifest::load(void)
+{
+	if(g_manifestLoaded)
+	{
+		return;
+	}
+
+	g_manifestLoaded = true;
+	QSettings settings(getManifestFile(), QSettings::IniFormat);
+
+	const int count = settings.beginReadArray(KEY_FILES);
+	for(int i = 0; i < count; i++)
+	{
+		settings.setArrayIndex(i);
+		manifest_entry_t entry;
+		entry.path   = settings.value(KEY_PATH).toString();
+		entry.size   = settings.value(KEY_SIZE, -1).toLongLong();
+		entry.time   = settings.value(KEY_TIME, -1).toLongLong();
+		entry.flags  = settings.value(KEY_FLAGS, 0).toInt();
+		entry.digest = settings.value(KEY_DIGEST).toString().toLatin1();
+		if(!entry.path.isEmpty())
+		{
+			g_manifest.insert(entry.path.toLower(), entry);
+		}
+	}
+	settings.endArray();
+}
+
+bool BinaryManifest::getFileStamp(const QString &filePath, QString &key, qint64 &size, qint64 &time)
+{
+	const QFileInfo fileInfo(filePath);
+	if(!fileInfo.isFile())
+	{
+		return false;
+	}
+
+	key = QDir::cleanPath(fileInfo.absoluteFilePath()).toLower();
+	size = fileInfo.size();
+	time = fileInfo.lastModified().toMSecsSinceEpoch();
+	return true;
+}
+
+QString BinaryManifest::getManifestFile(void)
+{
+	return QString("%1/binaries.ini").arg(x264_data_path());
+}
@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+
+class BinaryManifest
+{
+public:
+	typedef enum
+	{
+		FLAG_EXECUTABLE = 0x1,
+		FLAG_LIBRARY    = 0x2
+	}
+	flags_t;
+
+	static bool isVerified(const QString &filePath, const int &flag);
+	static void setVerified(const QString &filePath, const int &flag);
+	static bool lookupDigest(const QString &filePath, QByteArray &digest);
+	static void insertDigest(const QString &filePath, const QByteArray &digest);
+	static void save(void);
+
+private:
+	BinaryManifest(void)  {/*NOP*/}
+	~BinaryManifest(void) {/*NOP*/}
+
+	static void load(void);
+	static bool getFileStamp(const QString &filePath, QString &key, qint64 &size, qint64 &time);
+	static QString getManifestFile(void);
+};
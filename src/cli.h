@@ -42,3 +42,4 @@ static const char *const CLI_PARAM_CONSOLE_HIDE       = "no-console";
 static const char *const CLI_PARAM_CPU_NO_64BIT       = "force-cpu-no-64bit";
 static const char *const CLI_PARAM_CPU_NO_SSE         = "force-cpu-no-sse";
 static const char *const CLI_PARAM_CPU_NO_INTEL       = "force-cpu-no-intel";
+static const char *const CLI_PARAM_BENCH_PARSER       = "benchmark-line-parser";
@@ -0,0 +1,251 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "clipinfo_cache.h"
+
+//Internal
+#include "global.h"
+#include "model_clipInfo.h"
+
+//Qt
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSettings>
+#include <QMutex>
+#include <QRegExp>
+#include <QPair>
+#include <QCryptographicHash>
+
+/*
+ * The clip properties of Avisynth and VapourSynth scripts are cached in the data path, so that the script
+ * doesn't need to be executed again for every job. An entry is keyed by the source binary and the command-line
+ * of the check. It is valid as long as the content hash (SHA-1) of the script matches and none of the files
+ * referenced by the script (imported scripts, plugins, source files) has been changed. References are found by
+ * looking for quoted strings in the script that resolve to an existing file, which is a best-effort approach.
+ * Files that are loaded implicitly (e.g. auto-loaded plugins) are not tracked, except for the source binary.
+ */
+
+static const char *const KEY_DIGEST = "digest";
+static const char *const KEY_FRAMES = "frames";
+static const char *const KEY_WIDTH  = "width";
+static const char *const KEY_HEIGHT = "height";
+static const char *const KEY_FPSNUM = "fps_num";
+static const char *const KEY_FPSDEN = "fps_den";
+static const char *const KEY_REFS   = "refs";
+static const char *const KEY_PATH   = "path";
+static const char *const KEY_SIZE   = "size";
+static const char *const KEY_TIME   = "time";
+
+static const qint64 MAX_SCRIPT_SIZE = 4194304I64;
+static const int MAX_REFERENCES = 256;
+static const int MAX_IMPORT_DEPTH = 4;
+
+static QMutex g_clipInfoCacheMutex;
+
+bool ClipInfoCache::lookup(const QString &binaryPath, const QStringList &args, const QString &scriptFile, ClipInfo &clipInfo)
+{
+	QMutexLocker lock(&g_clipInfoCacheMutex);
+
+	QString digest;
+	if(!getScriptDigest(scriptFile, digest))
+	{
+		return false;
+	}
+
+	QSettings settings(getCacheFile(), QSettings::IniFormat);
+	settings.beginGroup(getEntryKey(binaryPath, args));
+
+	if(settings.value(KEY_DIGEST).toString().compare(digest, Qt::CaseInsensitive) != 0)
+	{
+		return false;
+	}
+
+	//Make sure that none of the referenced files has been changed
+	bool valid = true;
+	const int count = settings.beginReadArray(KEY_REFS);
+	for(int i = 0; (i < count) && valid; i++)
+	{
+		settings.setArrayIndex(i);
+		qint64 size = -1, time = -1;
+		if(!(getFileStamp(settings.value(KEY_PATH).toString(), size, time) && (settings.value(KEY_SIZE, -1).toLongLong() == size) && (settings.value(KEY_TIME, -1).toLongLong() == time)))
+		{
+			valid = false;
+		}
+	}
+	settings.endArray();
+
+	if(valid && (count > 0))
+	{
+		const quint32 frames = settings.value(KEY_FRAMES, 0U).toUInt();
+		if(frames > 0)
+		{
+			clipInfo.reset();
+			clipInfo.setFrameCount(frames);
+			clipInfo.setFrameSize(settings.value(KEY_WIDTH, 0U).toUInt(), settings.value(KEY_HEIGHT, 0U).toUInt());
+			clipInfo.setFrameRate(settings.value(KEY_FPSNUM, 0U).toUInt(), settings.value(KEY_FPSDEN, 0U).toUInt());
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ClipInfoCache::insert(const QString &binaryPath, const QStringList &args, const QString &scriptFile, const ClipInfo &clipInfo)
+{
+	QMutexLocker lock(&g_clipInfoCacheMutex);
+
+	QString digest;
+	if(!getScriptDigest(scriptFile, digest))
+	{
+		return;
+	}
+
+	QStringList references(QFileInfo(binaryPath).absoluteFilePath());
+	getReferencedFiles(scriptFile, references);
+
+	const QString entryKey = getEntryKey(binaryPath, args);
+	QSettings settings(getCacheFile(), QSettings::IniFormat);
+	settings.remove(entryKey);
+	settings.beginGroup(entryKey);
+
+	settings.beginWriteArray(KEY_REFS);
+	int index = 0;
+	for(QStringList::ConstIterator iter = references.constBegin(); iter != references.constEnd(); iter++)
+	{
+		qint64 size = -1, time = -1;
+		if(getFileStamp(*iter, size, time))
+		{
+			settings.setArrayIndex(index++);
+			settings.setValue(KEY_PATH, *iter);
+			settings.setValue(KEY_SIZE, size);
+			settings.setValue(KEY_TIME, time);
+		}
+	}
+	settings.endArray();
+
+	const QPair<quint32, quint32> frameSize = clipInfo.getFrameSize();
+	const QPair<quint32, quint32> frameRate = clipInfo.getFrameRate();
+
+	settings.setValue(KEY_DIGEST, digest);
+	settings.setValue(KEY_FRAMES, clipInfo.getFrameCount());
+	settings.setValue(KEY_WIDTH,  frameSize.first);
+	settings.setValue(KEY_HEIGHT, frameSize.second);
+	settings.setValue(KEY_FPSNUM, frameRate.first);
+	settings.setValue(KEY_FPSDEN, frameRate.second);
+	settings.endGroup();
+	settings.sync();
+}
+
+QString ClipInfoCache::getEntryKey(const QString &binaryPath, const QStringList &args)
+{
+	const QString key = QString("%1|%2").arg(QDir::cleanPath(QFileInfo(binaryPath).absoluteFilePath()).toLower(), args.join(QString("|")));
+	return QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex().constData());
+}
+
+bool ClipInfoCache::getScriptDigest(const QString &scriptFile, QString &digest)
+{
+	QFile file(scriptFile);
+	if((file.size() > MAX_SCRIPT_SIZE) || (!file.open(QIODevice::ReadOnly)))
+	{
+		return false;
+	}
+
+	const QByteArray content = file.readAll();
+	file.close();
+
+	digest = QString::fromLatin1(QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex().constData());
+	return true;
+}
+
+void ClipInfoCache::getReferencedFiles(const QString &scriptFile, QStringList &files, const int &depth)
+{
+	QFile file(scriptFile);
+	if((file.size() > MAX_SCRIPT_SIZE) || (!file.open(QIODevice::ReadOnly)))
+	{
+		return;
+	}
+
+	const QByteArray content = file.readAll();
+	file.close();
+
+	//The encoding of the script is unknown, so try UTF-8 as well as the local 8-Bit codepage
+	QStringList candidates;
+	const QString text[2] = { QString::fromUtf8(content.constData(), content.size()), QString::fromLocal8Bit(content.constData(), content.size()) };
+	for(size_t i = 0; i < 2; i++)
+	{
+		QRegExp quoted("([\"'])([^\"'\\r\\n]+)\\1");
+		int pos = 0;
+		while((pos = quoted.indexIn(text[i], pos)) >= 0)
+		{
+			candidates << quoted.cap(2).trimmed();
+			pos += qMax(quoted.matchedLength(), 1);
+		}
+	}
+
+	const QDir scriptDir = QFileInfo(scriptFile).absoluteDir();
+	for(QStringList::ConstIterator iter = candidates.constBegin(); (iter != candidates.constEnd()) && (files.count() < MAX_REFERENCES); iter++)
+	{
+		if(iter->isEmpty() || (!(iter->contains(QLatin1Char('.')) || iter->contains(QLatin1Char('/')) || iter->contains(QLatin1Char('\\')))))
+		{
+			continue;
+		}
+		const QFileInfo info(QDir::isAbsolutePath(*iter) ? (*iter) : scriptDir.absoluteFilePath(*iter));
+		if(!info.isFile())
+		{
+			continue;
+		}
+		const QString path = QDir::cleanPath(info.absoluteFilePath());
+		if(files.contains(path, Qt::CaseInsensitive))
+		{
+			continue;
+		}
+		files << path;
+
+		//Follow imported scripts, so that changes further down the chain are detected too
+		const QString suffix = info.suffix().toLower();
+		if((depth < MAX_IMPORT_DEPTH) && ((suffix == "avs") || (suffix == "avsi") || (suffix == "py") || (suffix == "vpy")))
+		{
+			getReferencedFiles(path, files, depth + 1);
+		}
+	}
+}
+
+bool ClipInfoCache::getFileStamp(const QString &filePath, qint64 &size, qint64 &time)
+{
+	const QFileInfo fileInfo(filePath);
+	if(!fileInfo.isFile())
+	{
+		return false;
+	}
+
+	size = fileInfo.size();
+	time = fileInfo.lastModified().toMSecsSinceEpoch();
+	return true;
+}
+
+QString ClipInfoCache::getCacheFile(void)
+{
+	return QString("%1/clipinfo_cache.ini").arg(x264_data_path());
+}
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+
+class QStringList;
+class QSettings;
+class ClipInfo;
+
+class ClipInfoCache
+{
+public:
+	static bool lookup(const QString &binaryPath, const QStringList &args, const QString &scriptFile, ClipInfo &clipInfo);
+	static void insert(const QString &binaryPath, const QStringList &args, const QString &scriptFile, const ClipInfo &clipInfo);
+
+private:
+	ClipInfoCache(void)  {/*NOP*/}
+	~ClipInfoCache(void) {/*NOP*/}
+
+	static QString getEntryKey(const QString &binaryPath, const QStringList &args);
+	static bool getScriptDigest(const QString &scriptFile, QString &digest);
+	static void getReferencedFiles(const QString &scriptFile, QStringList &files, const int &depth = 0);
+	static bool getFileStamp(const QString &filePath, qint64 &size, qint64 &time);
+	static QString getCacheFile(void);
+};
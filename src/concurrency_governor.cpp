@@ -0,0 +1,266 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "concurrency_governor.h"
+
+//Internal
+#include "global.h"
+#include "model_jobList.h"
+#include "model_preferences.h"
+#include "model_status.h"
+
+//Qt
+#include <QThread>
+
+//Windows includes
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+/*
+ * The concurrency governor replaces the fixed number of parallel jobs by a limit that adapts at runtime. It
+ * samples the CPU utilization and the memory load of the system as well as the frame rate of all running
+ * jobs. As long as the CPU is not saturated and there is work left, the limit is raised by one. After the new
+ * job had the time to settle, the aggregate throughput (frames/s of all jobs) is compared with the throughput
+ * before the change. If the throughput did not improve, the change is reverted and the limit is held for a
+ * while. High memory load always lowers the limit. Windows does not expose the length of the run-queue
+ * without the performance counter API, so the CPU utilization is used to detect saturation instead. If more
+ * jobs are running than the limit allows, the most recently started job is paused, paused jobs are resumed
+ * as soon as the limit permits.
+ */
+
+static const int SAMPLE_INTERVAL = 5000;
+static const unsigned int SETTLE_SAMPLES = 3U;
+static const unsigned int HOLD_PERIODS = 4U;
+static const double CPU_LOAD_HIGH = 0.85;
+static const unsigned int MEMORY_LOAD_HIGH = 90U;
+static const unsigned int MEMORY_LOAD_SAFE = 80U;
+static const double THROUGHPUT_GAIN = 1.03;
+
+static inline quint64 fileTimeToUInt64(const FILETIME &fileTime)
+{
+	return (quint64(fileTime.dwHighDateTime) << 32) | quint64(fileTime.dwLowDateTime);
+}
+
+static inline bool isActiveStatus(const JobStatus &status)
+{
+	return (status == JobStatus_Starting) || (status == JobStatus_Indexing) || (status == JobStatus_Running) ||
+		(status == JobStatus_Running_Pass1) || (status == JobStatus_Running_Pass2) || (status == JobStatus_Resuming);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor & Destructor
+///////////////////////////////////////////////////////////////////////////////
+
+ConcurrencyGovernor::ConcurrencyGovernor(JobListModel *const jobList, const PreferencesModel *const preferences)
+:
+	m_jobList(jobList),
+	m_preferences(preferences),
+	m_lastIdleTime(0),
+	m_lastTotalTime(0),
+	m_throughput(0.0),
+	m_lastThroughput(0.0),
+	m_samples(0),
+	m_holdCounter(0),
+	m_direction(0)
+{
+	m_limit = qMax(1U, m_preferences->getMaxRunningJobCount());
+	m_maxLimit = qMax(m_limit, qBound(1U, static_cast<unsigned int>(QThread::idealThreadCount()), 16U));
+	getCpuLoad();
+
+	connect(&m_timer, SIGNAL(timeout()), this, SLOT(sample()));
+	m_timer.start(SAMPLE_INTERVAL);
+}
+
+ConcurrencyGovernor::~ConcurrencyGovernor(void)
+{
+	m_timer.stop();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+bool ConcurrencyGovernor::resumeJob(void)
+{
+	double fps = 0.0;
+	bool pending = false;
+	const unsigned int active = updateJobs(fps, pending);
+
+	if((active < m_limit) && (!m_suspended.isEmpty()))
+	{
+		const QUuid jobId = m_suspended.takeLast();
+		qDebug("Concurrency governor: Resuming job (limit: %u)", m_limit);
+		return m_jobList->resumeJob(m_jobList->getJobIndexById(jobId));
+	}
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Sampling
+///////////////////////////////////////////////////////////////////////////////
+
+void ConcurrencyGovernor::sample(void)
+{
+	const double cpuLoad = getCpuLoad();
+	const unsigned int memoryLoad = getMemoryLoad();
+
+	double fps = 0.0;
+	bool pending = false;
+	unsigned int active = updateJobs(fps, pending);
+
+	m_throughput += fps;
+	m_samples++;
+
+	const unsigned int previousLimit = m_limit;
+	if(memoryLoad >= MEMORY_LOAD_HIGH)
+	{
+		//Memory pressure takes precedence, don't revert this change based on throughput
+		if((m_limit > 1U) && (m_samples >= SETTLE_SAMPLES))
+		{
+			qDebug("Concurrency governor: Memory load is %u%%, lowering the limit!", memoryLoad);
+			changeLimit(-1, 0);
+			m_holdCounter = HOLD_PERIODS;
+		}
+	}
+	else if(m_samples >= SETTLE_SAMPLES)
+	{
+		const double throughput = m_throughput / static_cast<double>(m_samples);
+		if((m_direction > 0) && (throughput < m_lastThroughput * THROUGHPUT_GAIN))
+		{
+			qDebug("Concurrency governor: No gain from the additional job (%.2f vs. %.2f fps), reverting!", throughput, m_lastThroughput);
+			changeLimit(-1, 0);
+			m_holdCounter = HOLD_PERIODS;
+		}
+		else if((m_holdCounter == 0) && (cpuLoad >= 0.0) && (cpuLoad < CPU_LOAD_HIGH) && (memoryLoad < MEMORY_LOAD_SAFE) && (pending || (!m_suspended.isEmpty())) && (m_limit < m_maxLimit) && (active >= m_limit))
+		{
+			qDebug("Concurrency governor: CPU load is %.0f%%, raising the limit!", cpuLoad * 100.0);
+			changeLimit(+1, +1);
+		}
+		else
+		{
+			if(m_holdCounter > 0) m_holdCounter--;
+			m_throughput = 0.0;
+			m_samples = 0;
+			m_direction = 0;
+		}
+	}
+
+	//Pause the most recently started jobs, if there are too many
+	const QList<QUuid> started = m_jobList->getActiveJobs();
+	for(int i = started.count() - 1; (i >= 0) && (active > m_limit); i--)
+	{
+		const QUuid jobId = started.at(i);
+		const QModelIndex index = m_jobList->getJobIndexById(jobId);
+		if(isActiveStatus(m_jobList->getJobStatus(index)) && m_jobList->pauseJob(index))
+		{
+			qDebug("Concurrency governor: Pausing job (limit: %u)", m_limit);
+			m_suspended.append(jobId);
+			active--;
+		}
+	}
+
+	if(m_limit > previousLimit)
+	{
+		while(resumeJob());
+		if(m_preferences->getAutoRunNextJob()) emit limitChanged();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Busy fraction of all CPUs since the previous call, or -1 if not available
+ */
+double ConcurrencyGovernor::getCpuLoad(void)
+{
+	FILETIME idleTime, kernelTime, userTime;
+	if(!GetSystemTimes(&idleTime, &kernelTime, &userTime))
+	{
+		return -1.0;
+	}
+
+	//The kernel time includes the idle time
+	const quint64 idle = fileTimeToUInt64(idleTime), total = fileTimeToUInt64(kernelTime) + fileTimeToUInt64(userTime);
+	const quint64 deltaIdle = idle - m_lastIdleTime, deltaTotal = total - m_lastTotalTime;
+	const bool valid = (m_lastTotalTime > 0) && (deltaTotal > 0) && (deltaIdle <= deltaTotal);
+
+	m_lastIdleTime = idle;
+	m_lastTotalTime = total;
+
+	return valid ? (static_cast<double>(deltaTotal - deltaIdle) / static_cast<double>(deltaTotal)) : -1.0;
+}
+
+unsigned int ConcurrencyGovernor::getMemoryLoad(void)
+{
+	MEMORYSTATUSEX memoryStatus;
+	memset(&memoryStatus, 0, sizeof(MEMORYSTATUSEX));
+	memoryStatus.dwLength = sizeof(MEMORYSTATUSEX);
+	if(GlobalMemoryStatusEx(&memoryStatus))
+	{
+		return static_cast<unsigned int>(memoryStatus.dwMemoryLoad);
+	}
+	return 0U;
+}
+
+/*
+ * Sum up the frame rate of the running jobs, returns the number of running jobs that are not paused
+ */
+unsigned int ConcurrencyGovernor::updateJobs(double &fps, bool &pending)
+{
+	unsigned int active = 0;
+	pending = (m_jobList->countJobs(JobStatus_Enqueued) > 0);
+
+	const QList<QUuid> &activeJobs = m_jobList->getActiveJobs();
+	for(QList<QUuid>::ConstIterator iter = activeJobs.constBegin(); iter != activeJobs.constEnd(); iter++)
+	{
+		const QModelIndex index = m_jobList->getJobIndexById(*iter);
+		if(isActiveStatus(m_jobList->getJobStatus(index)))
+		{
+			fps += m_jobList->getJobFps(index);
+			active++;
+		}
+	}
+
+	//Jobs that have finished or that have been resumed by the user are no longer ours
+	for(int i = m_suspended.count() - 1; i >= 0; i--)
+	{
+		const JobStatus status = m_jobList->getJobStatus(m_jobList->getJobIndexById(m_suspended.at(i)));
+		if((status != JobStatus_Pausing) && (status != JobStatus_Paused)) m_suspended.removeAt(i);
+	}
+
+	return active;
+}
+
+void ConcurrencyGovernor::changeLimit(const int &delta, const int &direction)
+{
+	m_lastThroughput = (m_samples > 0) ? (m_throughput / static_cast<double>(m_samples)) : 0.0;
+	m_limit = qBound(1U, static_cast<unsigned int>(static_cast<int>(m_limit) + delta), m_maxLimit);
+	m_direction = direction;
+	m_throughput = 0.0;
+	m_samples = 0;
+	qDebug("Concurrency governor: Limit is now %u", m_limit);
+}
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QObject>
+#include <QUuid>
+#include <QList>
+#include <QTimer>
+
+class JobListModel;
+class PreferencesModel;
+
+class ConcurrencyGovernor : public QObject
+{
+	Q_OBJECT
+
+public:
+	ConcurrencyGovernor(JobListModel *const jobList, const PreferencesModel *const preferences);
+	~ConcurrencyGovernor(void);
+
+	unsigned int getLimit(void) const { return m_limit; }
+	bool resumeJob(void);
+
+signals:
+	void limitChanged(void);
+
+protected:
+	JobListModel *const m_jobList;
+	const PreferencesModel *const m_preferences;
+	QTimer m_timer;
+
+	unsigned int m_limit;
+	unsigned int m_maxLimit;
+	QList<QUuid> m_suspended;
+
+	quint64 m_lastIdleTime;
+	quint64 m_lastTotalTime;
+	double m_throughput;
+	double m_lastThroughput;
+	unsigned int m_samples;
+	unsigned int m_holdCounter;
+	int m_direction;
+
+	double getCpuLoad(void);
+	unsigned int getMemoryLoad(void);
+	unsigned int updateJobs(double &fps, bool &pending);
+	void changeLimit(const int &delta, const int &direction);
+
+private slots:
+	void sample(void);
+};
@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "detection_cache.h"
+
+//Internal
+#include "global.h"
+
+//MUtils
+#include <MUtils/Global.h>
+#include <MUtils/OSSupport.h>
+
+//Qt
+#include <QStringList>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSettings>
+#include <QMutex>
+
+/*
+ * The results of the Avisynth and VapourSynth detection are cached in the data path, so that the detection
+ * doesn't have to be repeated at every start. An entry is valid as long as the size and time stamp of all of
+ * its stamp files (DLLs and executables) are unchanged. Files that did not exist at the time of the detection
+ * are recorded too, so that an entry becomes invalid when such a file shows up. Changes that are not visible
+ * in the file system (e.g. registry) are caught by the re-detection that is done in the background anyway.
+ */
+
+static const char *const KEY_FLAGS  = "flags";
+static const char *const KEY_PATHS  = "paths";
+static const char *const KEY_STAMPS = "stamps";
+static const char *const KEY_PATH   = "path";
+static const char *const KEY_SIZE   = "size";
+static const char *const KEY_TIME   = "time";
+
+static QMutex g_detectionCacheMutex;
+
+bool DetectionCache::lookup(const QString &name, int &flags, QStringList &paths)
+{
+	QMutexLocker lock(&g_detectionCacheMutex);
+
+	QSettings settings(getCacheFile(), QSettings::IniFormat);
+	if(!settings.childGroups().contains(name))
+	{
+		return false;
+	}
+
+	settings.beginGroup(name);
+
+	bool valid = true;
+	const int count = settings.beginReadArray(KEY_STAMPS);
+	for(int i = 0; (i < count) && valid; i++)
+	{
+		settings.setArrayIndex(i);
+		qint64 size = -1, time = -1;
+		getFileStamp(settings.value(KEY_PATH).toString(), size, time);
+		if((settings.value(KEY_SIZE, -1).toLongLong() != size) || (settings.value(KEY_TIME, -1).toLongLong() != time))
+		{
+			qDebug("Cached detection result \"%s\" is outdated.", MUTILS_UTF8(name));
+			valid = false;
+		}
+	}
+	settings.endArray();
+
+	if(valid && (count > 0))
+	{
+		flags = settings.value(KEY_FLAGS, 0).toInt();
+		paths = settings.value(KEY_PATHS).toStringList();
+		return true;
+	}
+
+	return false;
+}
+
+void DetectionCache::insert(const QString &name, const int &flags, const QStringList &paths, const QStringList &stampFiles)
+{
+	QMutexLocker lock(&g_detectionCacheMutex);
+
+	QSettings settings(getCacheFile(), QSettings::IniFormat);
+	settings.remove(name);
+	settings.beginGroup(name);
+
+	settings.beginWriteArray(KEY_STAMPS, stampFiles.count());
+	for(int i = 0; i < stampFiles.count(); i++)
+	{
+		qint64 size = -1, time = -1;
+		getFileStamp(stampFiles.at(i), size, time);
+		settings.setArrayIndex(i);
+		settings.setValue(KEY_PATH, stampFiles.at(i));
+		settings.setValue(KEY_SIZE, size);
+		settings.setValue(KEY_TIME, time);
+	}
+	settings.endArray();
+
+	settings.setValue(KEY_FLAGS, flags);
+	settings.setValue(KEY_PATHS, paths);
+	settings.endGroup();
+	settings.sync();
+}
+
+void DetectionCache::getFileStamp(const QString &filePath, qint64 &size, qint64 &time)
+{
+	//The DLL paths are reported as seen by the 32-Bit *and* the 64-Bit process, so don't let WOW64 redirect them
+	uintptr_t oldValue = 0;
+	const bool disabled = MUtils::OS::wow64fsredir_disable(oldValue);
+
+	const QFileInfo fileInfo(filePath);
+	if(fileInfo.isFile())
+	{
+		size = fileInfo.size();
+		time = fileInfo.lastModified().toMSecsSinceEpoch();
+	}
+	else
+	{
+		size = time = -1;
+	}
+
+	if(disabled)
+	{
+		MUtils::OS::wow64fsredir_revert(oldValue);
+	}
+}
+
+QString DetectionCache::getCacheFile(void)
+{
+	return QString("%1/detection.ini").arg(x264_data_path());
+}
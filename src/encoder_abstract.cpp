@@ -28,6 +28,10 @@
 #include "model_sysinfo.h"
 #include "model_status.h"
 #include "source_abstract.h"
+#include "frame_pump.h"
+#include "line_parser.h"
+#include "size_estimator.h"
+#include "index_cache.h"
 
 //MUtils
 #include <MUtils/Global.h>
@@ -43,6 +47,8 @@
 #include <QTime>
 #include <QThread>
 #include <QLocale>
+#include <QElapsedTimer>
+#include <QScopedPointer>
 
 // ------------------------------------------------------------
 // Constructor & Destructor
@@ -53,7 +59,10 @@ AbstractEncoder::AbstractEncoder(JobObject *jobObject, const OptionsModel *optio
 	AbstractTool(jobObject, options, sysinfo, preferences, jobStatus, abort, pause, semaphorePause),
 	m_sourceFile(sourceFile),
 	m_outputFile(outputFile),
-	m_indexFile(QString("%1/~%2.ffindex").arg(QDir::tempPath(), stringToHash(m_sourceFile)))
+	m_indexFile(IndexCache::getIndexFile(m_sourceFile)),
+	m_firstFrame(0),
+	m_frameCount(0),
+	m_threadBudget(0)
 {
 	/*Nothing to do here*/
 }
@@ -67,29 +76,45 @@ AbstractEncoder::~AbstractEncoder(void)
 // Encoding Functions
 // ------------------------------------------------------------
 
+void AbstractEncoder::setFrameRange(const quint32 &firstFrame, const quint32 &frameCount)
+{
+	m_firstFrame = firstFrame;
+	m_frameCount = frameCount;
+}
+
 bool AbstractEncoder::runEncodingPass(AbstractSource* pipedSource, const QString outputFile, const ClipInfo &clipInfo, const int &pass, const QString &passLogFile)
 {
 	QProcess processEncode, processInput;
+	QScopedPointer<FramePump> framePump;
+
+	//Clip properties not known yet? Then they are going to be detected from the stream (requires the frame pump)
+	const bool streamProbe = pipedSource && (clipInfo.getFrameCount() < 1);
+	ClipInfo streamInfo(clipInfo);
+	LineSplitter streamSplitter;
 	
 	if(pipedSource)
 	{
-		pipedSource->createProcess(processEncode, processInput);
+		const unsigned int bufferFrames = m_preferences->getFrameBufferCount();
+		const bool usePump = streamProbe || m_preferences->getEnableFramePump() || (bufferFrames > 0);
+		pipedSource->setStreamProbe(streamProbe);
+		pipedSource->createProcess(processEncode, processInput, usePump);
+		if(usePump)
+		{
+			framePump.reset(new FramePump(processInput, processEncode, bufferFrames, m_preferences->getFrameBufferLimit()));
+		}
 	}
 
-	QStringList cmdLine_Encode;
-	buildCommandLine(cmdLine_Encode, (pipedSource != NULL), clipInfo, m_indexFile, pass, passLogFile);
-
-	log("Creating encoder process:");
-	if(!startProcess(processEncode, getBinaryPath(), cmdLine_Encode, true, &getExtraPaths(), &getExtraEnv()))
+	if(!startEncoderProcess(processEncode, (pipedSource != NULL), clipInfo, pass, passLogFile))
 	{
 		return false;
 	}
 
-	QList<QRegExp*> patterns;
-	runEncodingPass_init(patterns);
+	LineParser parser;
+	LineSplitter splitter;
+	runEncodingPass_init(parser);
 	
 	double last_progress = 0.0;
-	double size_estimate = 0.0;
+	SizeEstimator estimator(m_outputFile, clipInfo);
 	
 	bool bTimeout = false;
 	bool bAborted = false;
@@ -118,7 +143,7 @@ bool AbstractEncoder::runEncodingPass(AbstractSource* pipedSource, const QString
 				QProcess *proc[2] = { &processEncode, &processInput };
 				ok[0] = MUtils::OS::suspend_process(proc[0], true);
 				ok[1] = MUtils::OS::suspend_process(proc[1], true);
-				while(*m_pause) m_semaphorePause->tryAcquire(1, 5000);
+				while(*m_pause) m_semaphorePause->acquire();
 				while(m_semaphorePause->tryAcquire(1, 0));
 				ok[0] = MUtils::OS::suspend_process(proc[0], false);
 				ok[1] = MUtils::OS::suspend_process(proc[1], false);
@@ -127,7 +152,7 @@ bool AbstractEncoder::runEncodingPass(AbstractSource* pipedSource, const QString
 				waitCounter = 0;
 				continue;
 			}
-			if(!processEncode.waitForReadyRead(m_processTimeoutInterval))
+			if(!waitForOutput(processEncode, framePump.data(), m_processTimeoutInterval))
 			{
 				if(processEncode.state() == QProcess::Running)
 				{
@@ -164,12 +189,28 @@ bool AbstractEncoder::runEncodingPass(AbstractSource* pipedSource, const QString
 		}
 
 		//Process all output
-		PROCESS_PENDING_LINES(processEncode, runEncodingPass_parseLine, patterns, clipInfo, pass, last_progress, size_estimate);
+		PROCESS_PENDING_LINES(processEncode, splitter, runEncodingPass_parseLine, parser, clipInfo, pass, last_progress, estimator);
+
+		//Without the number of frames, the encoder can't report the progress, so we derive it from the frames pumped so far
+		if(streamProbe)
+		{
+			updateStreamInfo(pipedSource, processInput, *framePump, streamSplitter, streamInfo);
+			if(streamInfo.getFrameCount() > 0)
+			{
+				const double progress = qMin(double(framePump->getFramesTransferred()) / double(streamInfo.getFrameCount()), 0.999);
+				if(!qFuzzyCompare(progress, last_progress))
+				{
+					setProgress(static_cast<unsigned int>(progress * 100.0));
+					estimator.update(progress);
+					last_progress = progress;
+				}
+			}
+		}
 	}
 	
 	if(!(bTimeout || bAborted))
 	{
-		PROCESS_PENDING_LINES(processEncode, runEncodingPass_parseLine, patterns, clipInfo, pass, last_progress, size_estimate);
+		FLUSH_PENDING_LINES(processEncode, splitter, runEncodingPass_parseLine, parser, clipInfo, pass, last_progress, estimator);
 	}
 
 	processEncode.waitForFinished(5000);
@@ -182,28 +223,44 @@ bool AbstractEncoder::runEncodingPass(AbstractSource* pipedSource, const QString
 	
 	if(pipedSource)
 	{
-		processInput.waitForFinished(5000);
-		if(processInput.state() != QProcess::NotRunning)
+		if(streamProbe && (!(bTimeout || bAborted)))
 		{
-			qWarning("Input process still running, going to kill it!");
-			processInput.kill();
-			processInput.waitForFinished(-1);
-		}
-		if(!(bTimeout || bAborted))
-		{
-			pipedSource->flushProcess(processInput);
+			processInput.waitForFinished(5000);
+			updateStreamInfo(pipedSource, processInput, *framePump, streamSplitter, streamInfo, true);
 		}
+		finishInputProcess(pipedSource, processInput, (!framePump.isNull()), (bTimeout || bAborted));
+	}
+
+	if(!framePump.isNull())
+	{
+		logFramePump(*framePump);
 	}
 
-	while(!patterns.isEmpty())
+	const bool success = finishEncoderProcess(processEncode, (bTimeout || bAborted), pass);
+	processInput.close();
+	return success;
+}
+
+bool AbstractEncoder::startEncoderProcess(QProcess &processEncode, const bool &usePipe, const ClipInfo &clipInfo, const int &pass, const QString &passLogFile)
+{
+	//Mark a cached index as recently used
+	if(!usePipe)
 	{
-		QRegExp *pattern = patterns.takeFirst();
-		MUTILS_DELETE(pattern);
+		IndexCache::touch(m_indexFile);
 	}
 
-	if(bTimeout || bAborted || processEncode.exitCode() != EXIT_SUCCESS)
+	QStringList cmdLine_Encode;
+	buildCommandLine(cmdLine_Encode, usePipe, clipInfo, m_indexFile, pass, passLogFile);
+
+	log("Creating encoder process:");
+	return startProcess(processEncode, getBinaryPath(), cmdLine_Encode, true, &getExtraPaths(), &getExtraEnv());
+}
+
+bool AbstractEncoder::finishEncoderProcess(QProcess &processEncode, const bool &interrupted, const int &pass)
+{
+	if(interrupted || processEncode.exitCode() != EXIT_SUCCESS)
 	{
-		if(!(bTimeout || bAborted))
+		if(!interrupted)
 		{
 			const int exitCode = processEncode.exitCode();
 			if((exitCode < -1) || (exitCode >= 32))
@@ -214,7 +271,6 @@ bool AbstractEncoder::runEncodingPass(AbstractSource* pipedSource, const QString
 			log(tr("\nPROCESS EXITED WITH ERROR CODE: %1").arg(QString::number(exitCode)));
 		}
 		processEncode.close();
-		processInput.close();
 		return false;
 	}
 
@@ -242,29 +298,338 @@ bool AbstractEncoder::runEncodingPass(AbstractSource* pipedSource, const QString
 
 	setProgress(100);
 	processEncode.close();
-	processInput.close();
 	return true;
 }
 
+void AbstractEncoder::finishInputProcess(AbstractSource *pipedSource, QProcess &processInput, const bool &usePump, const bool &interrupted)
+{
+	if(usePump)
+	{
+		processInput.closeReadChannel(QProcess::StandardOutput);
+		processInput.setReadChannel(QProcess::StandardError);
+	}
+	processInput.waitForFinished(5000);
+	if(processInput.state() != QProcess::NotRunning)
+	{
+		qWarning("Input process still running, going to kill it!");
+		processInput.kill();
+		processInput.waitForFinished(-1);
+	}
+	if(!interrupted)
+	{
+		pipedSource->flushProcess(processInput);
+	}
+}
+
+void AbstractEncoder::updateStreamInfo(AbstractSource *pipedSource, QProcess &processInput, const FramePump &framePump, LineSplitter &splitter, ClipInfo &streamInfo, const bool &flush)
+{
+	const quint32 frameCount = streamInfo.getFrameCount();
+
+	//Frame size and frame rate are taken from the YUV4MPEG2 header, as soon as the frame pump has parsed it
+	if((streamInfo.getFrameSize().first < 1) && framePump.hasStreamInfo())
+	{
+		const MediaInfo::yuv4mpeg_t &info = framePump.getStreamInfo();
+		streamInfo.setFrameSize(info.width, info.height);
+		streamInfo.setFrameRate(info.fpsNum, info.fpsDen);
+		log(tr("Stream properties: %1 x %2, %3/%4 fps").arg(QString::number(info.width), QString::number(info.height), QString::number(info.fpsNum), QString::number(info.fpsDen)));
+	}
+
+	//Number of frames is reported by the source tool on its stderr
+	pipedSource->checkStreamProperties(processInput, splitter, streamInfo, flush);
+	if((frameCount < 1) && (streamInfo.getFrameCount() > 0))
+	{
+		log(tr("Number of frames reported by the source: %1").arg(QString::number(streamInfo.getFrameCount())));
+	}
+}
+
+void AbstractEncoder::logFramePump(const FramePump &framePump)
+{
+	if(framePump.getBytesTransferred() < 1)
+	{
+		return;
+	}
+
+	const QString throughput = tr("%1/s").arg(sizeToString(qRound64(framePump.getBytesPerSecond())));
+	if(framePump.hasStreamInfo())
+	{
+		log(tr("\nFrame pump: %1 frames (%2) in %3 seconds, %4 fps, %5.").arg(QString::number(framePump.getFramesTransferred()), sizeToString(framePump.getBytesTransferred()), QString::number(framePump.getElapsedTime(), 'f', 1), QString::number(framePump.getFramesPerSecond(), 'f', 2), throughput));
+	}
+	else
+	{
+		log(tr("\nFrame pump: %1 in %2 seconds, %3.").arg(sizeToString(framePump.getBytesTransferred()), QString::number(framePump.getElapsedTime(), 'f', 1), throughput));
+	}
+	if(framePump.hasFrameBuffer() && framePump.hasStreamInfo())
+	{
+		log(tr("Frame buffer: %1 frames capacity, %2 frames average fill, %3 frames peak fill.").arg(QString::number(framePump.getBufferCapacity(), 'f', 1), QString::number(framePump.getBufferAverageFill(), 'f', 1), QString::number(framePump.getBufferPeakFill(), 'f', 1)));
+		log(tr("Frame buffer: full %1% of the time (encoder-bound), empty %2% of the time (source-bound).").arg(QString::number(100.0 * framePump.getBufferFullRatio(), 'f', 1), QString::number(100.0 * framePump.getBufferEmptyRatio(), 'f', 1)));
+	}
+}
+
 // ------------------------------------------------------------
-// Utilities
+// Shared Encoding
 // ------------------------------------------------------------
 
-double AbstractEncoder::estimateSize(const QString &fileName, const double &progress)
+/*
+ * Feeds the output of a single piped source into several encoders at once, so that the source is decoded only once.
+ * All processes must be driven from the calling thread (QProcess has thread affinity), so one loop serves all encoders.
+ * The frame pump forwards the data at the pace of the slowest encoder; pausing or aborting one output affects only that output.
+ */
+
+typedef struct
+{
+	AbstractEncoder *encoder;
+	QProcess *process;
+	LineParser *parser;
+	LineSplitter *splitter;
+	SizeEstimator *estimator;
+	QElapsedTimer lastOutput;
+	double lastProgress;
+	JobStatus previousStatus;
+	bool started;
+	bool running;
+	bool paused;
+	bool interrupted;
+	bool warned;
+}
+shared_output_t;
+
+bool AbstractEncoder::runSharedEncodingPass(AbstractSource *pipedSource, const QList<AbstractEncoder*> &encoders, const ClipInfo &clipInfo, QList<bool> &results)
 {
-	double estimatedSize = 0.0;
-	if(progress >= 0.03)
+	static const qint64 TIMEOUT_WARNING = qint64(m_processTimeoutWarning) * qint64(m_processTimeoutInterval);
+	static const qint64 TIMEOUT_ABORT   = qint64(m_processTimeoutMaxCounter) * qint64(m_processTimeoutInterval);
+
+	AbstractEncoder *const leader = encoders.first();
+	QList<shared_output_t> outputs;
+	QProcess processInput;
+
+	for(QList<AbstractEncoder*>::ConstIterator iter = encoders.constBegin(); iter != encoders.constEnd(); iter++)
 	{
-		QFileInfo fileInfo(fileName);
-		if(fileInfo.exists() && fileInfo.isFile())
+		shared_output_t output;
+		output.encoder = (*iter);
+		output.process = new QProcess();
+		output.parser = new LineParser();
+		output.splitter = new LineSplitter();
+		output.estimator = new SizeEstimator((*iter)->m_outputFile, clipInfo);
+		output.lastProgress = 0.0;
+		output.previousStatus = JobStatus_Running;
+		output.started = output.running = output.paused = output.interrupted = output.warned = false;
+		(*iter)->runEncodingPass_init(*output.parser);
+		outputs.append(output);
+	}
+
+	//Start the source, the frame pump forwards its output to all encoders
+	const bool sourceStarted = pipedSource->createProcess(*outputs.first().process, processInput, true);
+	FramePump framePump(processInput, *outputs.first().process, leader->m_preferences->getFrameBufferCount(), leader->m_preferences->getFrameBufferLimit());
+
+	for(QList<shared_output_t>::Iterator iter = outputs.begin(); iter != outputs.end(); iter++)
+	{
+		if(iter != outputs.begin())
 		{
-			const qint64 currentSize = QFileInfo(fileName).size();
-			estimatedSize = static_cast<double>(currentSize) * (1.0 / qBound(0.0, progress, 1.0));
+			framePump.addConsumer(*iter->process);
+		}
+		if(sourceStarted)
+		{
+			iter->started = iter->running = iter->encoder->startEncoderProcess(*iter->process, true, clipInfo, 0, QString());
+			iter->lastOutput.start();
+		}
+		if(!iter->running)
+		{
+			framePump.removeConsumer(*iter->process);
 		}
 	}
-	return estimatedSize;
+
+	//Main processing loop
+	forever
+	{
+		QProcess *waitProcess = NULL;
+		bool anyPaused = false;
+
+		for(QList<shared_output_t>::Iterator iter = outputs.begin(); iter != outputs.end(); iter++)
+		{
+			if(!iter->running)
+			{
+				continue;
+			}
+
+			AbstractEncoder *const encoder = iter->encoder;
+			if(*encoder->m_abort)
+			{
+				iter->process->kill();
+				framePump.removeConsumer(*iter->process);
+				iter->running = false;
+				iter->interrupted = true;
+				continue;
+			}
+
+			//An attached output that is paused would stall all the others, so it is detached from the source instead
+			if((*encoder->m_pause) && (iter != outputs.begin()))
+			{
+				iter->process->kill();
+				framePump.removeConsumer(*iter->process);
+				iter->running = false;
+				iter->interrupted = true;
+				encoder->log(tr("\nJob paused by user at %1, %2.").arg(QDate::currentDate().toString(Qt::ISODate), QTime::currentTime().toString( Qt::ISODate)));
+				continue;
+			}
+
+			//Pausing the leading output suspends its encoder, the others will stall once the frame buffer is full
+			if((*encoder->m_pause) != iter->paused)
+			{
+				iter->paused = (*encoder->m_pause);
+				if(iter->paused)
+				{
+					iter->previousStatus = encoder->m_jobStatus;
+					encoder->setStatus(JobStatus_Paused);
+					encoder->log(tr("Job paused by user at %1, %2.").arg(QDate::currentDate().toString(Qt::ISODate), QTime::currentTime().toString( Qt::ISODate)));
+				}
+				else
+				{
+					while(encoder->m_semaphorePause->tryAcquire(1, 0));
+					encoder->setStatus(iter->previousStatus);
+					encoder->log(tr("Job resumed by user at %1, %2.").arg(QDate::currentDate().toString(Qt::ISODate), QTime::currentTime().toString( Qt::ISODate)));
+				}
+				MUtils::OS::suspend_process(iter->process, iter->paused);
+			}
+			if(iter->paused)
+			{
+				anyPaused = true;
+				continue;
+			}
+
+			//Process all output
+			if((iter->process->bytesAvailable() > 0) || iter->process->waitForReadyRead(0))
+			{
+				iter->lastOutput.restart();
+				iter->warned = false;
+				PROCESS_PENDING_LINES(*iter->process, *iter->splitter, encoder->runEncodingPass_parseLine, *iter->parser, clipInfo, 0, iter->lastProgress, *iter->estimator);
+			}
+
+			if(iter->process->state() == QProcess::NotRunning)
+			{
+				FLUSH_PENDING_LINES(*iter->process, *iter->splitter, encoder->runEncodingPass_parseLine, *iter->parser, clipInfo, 0, iter->lastProgress, *iter->estimator);
+				framePump.removeConsumer(*iter->process);
+				iter->running = false;
+				continue;
+			}
+
+			if(iter->lastOutput.hasExpired(TIMEOUT_ABORT) && leader->m_preferences->getAbortOnTimeout())
+			{
+				iter->process->kill();
+				qWarning("encoder process timed out <-- killing!");
+				encoder->log("\nPROCESS TIMEOUT !!!");
+				framePump.removeConsumer(*iter->process);
+				iter->running = false;
+				iter->interrupted = true;
+				continue;
+			}
+			else if(iter->lastOutput.hasExpired(TIMEOUT_WARNING) && (!iter->warned))
+			{
+				encoder->log(tr("Warning: encoder did not respond for %1 seconds, potential deadlock...").arg(QString::number(TIMEOUT_WARNING / 1000I64)));
+				iter->warned = true;
+			}
+
+			if(!waitProcess)
+			{
+				waitProcess = iter->process;
+			}
+		}
+
+		//All outputs have finished?
+		if((!waitProcess) && (!anyPaused))
+		{
+			break;
+		}
+
+		//A paused output holds back the others, which must not run into a timeout meanwhile
+		if(anyPaused)
+		{
+			for(QList<shared_output_t>::Iterator iter = outputs.begin(); iter != outputs.end(); iter++)
+			{
+				iter->lastOutput.restart();
+			}
+		}
+
+		//Keep the frames flowing, or wait for new output
+		if(!framePump.isFinished())
+		{
+			framePump.transfer(FramePump::m_transferInterval);
+		}
+		else if(waitProcess)
+		{
+			waitProcess->waitForReadyRead(m_processControlInterval);
+		}
+		else
+		{
+			QThread::msleep(m_processControlInterval);
+		}
+	}
+
+	//Clean up all processes
+	bool interrupted = (!sourceStarted);
+	for(QList<shared_output_t>::Iterator iter = outputs.begin(); iter != outputs.end(); iter++)
+	{
+		iter->process->waitForFinished(5000);
+		if(iter->process->state() != QProcess::NotRunning)
+		{
+			qWarning("Encoder process still running, going to kill it!");
+			iter->process->kill();
+			iter->process->waitForFinished(-1);
+		}
+		interrupted = interrupted || iter->interrupted;
+	}
+
+	if(sourceStarted)
+	{
+		leader->finishInputProcess(pipedSource, processInput, true, interrupted);
+		leader->logFramePump(framePump);
+	}
+
+	results.clear();
+	for(QList<shared_output_t>::Iterator iter = outputs.begin(); iter != outputs.end(); iter++)
+	{
+		results << (iter->started && iter->encoder->finishEncoderProcess(*iter->process, iter->interrupted, 0));
+		MUTILS_DELETE(iter->process);
+		MUTILS_DELETE(iter->parser);
+		MUTILS_DELETE(iter->splitter);
+		MUTILS_DELETE(iter->estimator);
+	}
+
+	return results.first();
+}
+
+bool AbstractEncoder::waitForOutput(QProcess &processEncode, FramePump *const framePump, const int &timeout)
+{
+	if((!framePump) || framePump->isFinished())
+	{
+		return waitForReadyRead(processEncode, timeout, true);
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	//Keep the frames flowing while we are waiting for the encoder's output
+	do
+	{
+		framePump->transfer(FramePump::m_transferInterval);
+		if((processEncode.bytesAvailable() > 0) || processEncode.waitForReadyRead(0))
+		{
+			return true;
+		}
+		if((*m_abort) || (*m_pause) || (processEncode.state() != QProcess::Running))
+		{
+			return false;
+		}
+	}
+	while((!framePump->isFinished()) && (!timer.hasExpired(timeout)));
+
+	const qint64 remaining = qint64(timeout) - timer.elapsed();
+	return (remaining > 0) ? waitForReadyRead(processEncode, int(remaining), true) : false;
 }
 
+// ------------------------------------------------------------
+// Utilities
+// ------------------------------------------------------------
+
 QString AbstractEncoder::sizeToString(qint64 size)
 {
 	static char *prefix[5] = {"Byte", "KB", "MB", "GB", "TB"};
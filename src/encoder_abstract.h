@@ -29,6 +29,10 @@ template<class T> class QList;
 template <class T1, class T2> struct QPair;
 class AbstractSource;
 class ClipInfo;
+class FramePump;
+class LineParser;
+class LineSplitter;
+class SizeEstimator;
 
 class AbstractEncoderInfo
 {
@@ -80,19 +84,35 @@ public:
 	virtual ~AbstractEncoder(void);
 
 	virtual bool runEncodingPass(AbstractSource* pipedSource, const QString outputFile, const ClipInfo &clipInfo, const int &pass = 0, const QString &passLogFile = QString());
+	static bool runSharedEncodingPass(AbstractSource *pipedSource, const QList<AbstractEncoder*> &encoders, const ClipInfo &clipInfo, QList<bool> &results);
 	
 	virtual const AbstractEncoderInfo& getEncoderInfo(void) const = 0;
+	virtual bool getIndexCommand(QString &program, QStringList &args) const { return false; }
+	const QString &getIndexFile(void) const { return m_indexFile; }
+
+	void setFrameRange(const quint32 &firstFrame, const quint32 &frameCount);
+	void setThreadBudget(const unsigned int &threads) { m_threadBudget = threads; }
 
 protected:
 	virtual void buildCommandLine(QStringList &cmdLine, const bool &usePipe, const ClipInfo &clipInfo, const QString &indexFile, const int &pass, const QString &passLogFile) = 0;
 
-	virtual void runEncodingPass_init(QList<QRegExp*> &patterns) = 0;
-	virtual void runEncodingPass_parseLine(const QString &line, const QList<QRegExp*> &patterns, const ClipInfo &clipInfo, const int &pass, double &last_progress, double &size_estimate) = 0;
+	virtual void runEncodingPass_init(LineParser &parser) = 0;
+	virtual void runEncodingPass_parseLine(const QLatin1String &line, const LineParser &parser, const ClipInfo &clipInfo, const int &pass, double &last_progress, SizeEstimator &estimator) = 0;
+
+	bool startEncoderProcess(QProcess &processEncode, const bool &usePipe, const ClipInfo &clipInfo, const int &pass, const QString &passLogFile);
+	bool finishEncoderProcess(QProcess &processEncode, const bool &interrupted, const int &pass);
+	void finishInputProcess(AbstractSource *pipedSource, QProcess &processInput, const bool &usePump, const bool &interrupted);
+	void logFramePump(const FramePump &framePump);
+	void updateStreamInfo(AbstractSource *pipedSource, QProcess &processInput, const FramePump &framePump, LineSplitter &splitter, ClipInfo &streamInfo, const bool &flush = false);
+	bool waitForOutput(QProcess &processEncode, FramePump *const framePump, const int &timeout);
 
-	static double estimateSize(const QString &fileName, const double &progress);
 	static QString sizeToString(qint64 size);
 
 	const QString &m_sourceFile;
 	const QString &m_outputFile;
 	const QString m_indexFile;
+
+	quint32 m_firstFrame;
+	quint32 m_frameCount;
+	unsigned int m_threadBudget;
 };
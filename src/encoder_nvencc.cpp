@@ -28,6 +28,8 @@
 #include "mediainfo.h"
 #include "model_sysinfo.h"
 #include "model_clipInfo.h"
+#include "line_parser.h"
+#include "size_estimator.h"
 
 //MUtils
 #include <MUtils/Global.h>
@@ -48,41 +50,46 @@ static const unsigned int VERSION_NVENCC_MINIMUM_VER = 501;
 
 #define NVENCC_UPDATE_PROGRESS(X) do \
 { \
-	bool ok[2] = { false, false }; \
-	unsigned int progressInt = (X)->cap(1).toUInt(&ok[0]); \
-	unsigned int progressFrc = (X)->cap(2).toUInt(&ok[1]); \
 	setStatus(JobStatus_Running); \
-	if(ok[0] && ok[1]) \
+	const double progress = (double((X).values[0]) / 100.0) + (double((X).values[1]) / 1000.0); \
+	if(!qFuzzyCompare(progress, last_progress)) \
 	{ \
-		const double progress = (double(progressInt) / 100.0) + (double(progressFrc) / 1000.0); \
-		if(!qFuzzyCompare(progress, last_progress)) \
-		{ \
-			setProgress(floor(progress * 100.0)); \
-			size_estimate = qFuzzyIsNull(size_estimate) ? estimateSize(m_outputFile, progress) : ((0.667 * size_estimate) + (0.333 * estimateSize(m_outputFile, progress))); \
-			last_progress = progress; \
-		} \
+		setProgress(floor(progress * 100.0)); \
+		estimator.update(progress); \
+		last_progress = progress; \
 	} \
-	setDetails(line.mid(offset).trimmed()); \
+	setDetails(QString::fromUtf8(line.latin1() + (X).offset)); \
 } \
 while(0)
 
 #define NVENCC_UPDATE_PROGRESS_OLD(X) do \
 { \
-	bool ok = false; \
-	unsigned int progressFrames = (X)->cap(1).toUInt(&ok); \
 	double progress = 0.0; \
 	setStatus(JobStatus_Running); \
-	if(ok && (clipInfo.getFrameCount() > 0)) \
+	if(clipInfo.getFrameCount() > 0) \
 	{ \
-		progress = (double(progressFrames) / double(clipInfo.getFrameCount())); \
+		progress = (double((X).values[0]) / double(clipInfo.getFrameCount())); \
 		if(!qFuzzyCompare(progress, last_progress)) \
 		{ \
 			setProgress(floor(progress * 100.0)); \
-			size_estimate = qFuzzyIsNull(size_estimate) ? estimateSize(m_outputFile, progress) : ((0.667 * size_estimate) + (0.333 * estimateSize(m_outputFile, progress))); \
+			estimator.update(progress); \
 			last_progress = progress; \
 		} \
 	} \
-	setDetails(tr("[%1] %2, est. file size %3").arg(QString().sprintf("%.1f%%", 100.0 * progress), line.mid(offset).trimmed(), sizeToString(qRound64(size_estimate)))); \
+	setDetails(tr("[%1] %2, est. file size %3").arg(QString().sprintf("%.1f%%", 100.0 * progress), QString::fromUtf8(line.latin1() + (X).offset), sizeToString(qRound64(estimator.getSize())))); \
+} \
+while(0)
+
+#define NVENCC_UPDATE_BITRATE(X, FRAMES, KBPS) do \
+{ \
+	estimator.setBitrate((X).values[(FRAMES)], double((X).values[(KBPS)])); \
+} \
+while(0)
+
+#define NVENCC_UPDATE_STATISTICS(X, FPS, ETA) do \
+{ \
+	const double fps = double((X).values[(FPS)]) + (double((X).values[(FPS) + 1]) / 100.0); \
+	setStatistics(fps, ((X).values[(ETA)] * 3600U) + ((X).values[(ETA) + 1] * 60U) + (X).values[(ETA) + 2]); \
 } \
 while(0)
 
@@ -273,8 +280,9 @@ void NVEncEncoder::checkVersion_init(QList<QRegExp*> &patterns, QStringList &cmd
 	patterns << new QRegExp("\\bNVEncC\\s+\\(x\\d+\\)\\s+(\\d)\\.(\\d+)\\s+\\(r(\\d+)\\)", Qt::CaseInsensitive);
 }
 
-void NVEncEncoder::checkVersion_parseLine(const QString &line, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified)
+void NVEncEncoder::checkVersion_parseLine(const QLatin1String &rawLine, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified)
 {
+	const QString line = QString::fromUtf8(rawLine.latin1());
 	if(patterns[0]->lastIndexIn(line) >= 0)
 	{
 		unsigned int temp[3];
@@ -406,35 +414,41 @@ void NVEncEncoder::buildCommandLine(QStringList &cmdLine, const bool &usePipe, c
 	}
 }
 
-void NVEncEncoder::runEncodingPass_init(QList<QRegExp*> &patterns)
+void NVEncEncoder::runEncodingPass_init(LineParser &parser)
 {
-	patterns << new QRegExp("\\[(\\d+)\\.(\\d+)%\\].+frames", Qt::CaseInsensitive);
-	patterns << new QRegExp("^(\\d+) frames:", Qt::CaseInsensitive);
-	patterns << new QRegExp("Selected\\s+codec\\s+is\\s+not\\s+supported", Qt::CaseInsensitive);
-	patterns << new QRegExp("nvEncodeAPI.dll\\s+does\\s+not\\s+exists\\s+in\\s+your\\s+system", Qt::CaseInsensitive);
+	parser.addPattern("[%u.%u%%] %u frames: %u.%u fps, %u kb/s, remain %u:%u:%u", false);
+	parser.addPattern("[%u.%u%%]%*frames", false);
+	parser.addPattern("^%u frames:", false);
+	parser.addPattern("Selected codec is not supported", false);
+	parser.addPattern("nvEncodeAPI.dll does not exists in your system", false);
 }
 
-void NVEncEncoder::runEncodingPass_parseLine(const QString &line, const QList<QRegExp*> &patterns, const ClipInfo &clipInfo, const int &pass, double &last_progress, double &size_estimate)
+void NVEncEncoder::runEncodingPass_parseLine(const QLatin1String &line, const LineParser &parser, const ClipInfo &clipInfo, const int &pass, double &last_progress, SizeEstimator &estimator)
 {
-	int offset = -1;
-	if((offset = patterns[0]->lastIndexIn(line)) >= 0)
-	{
-		NVENCC_UPDATE_PROGRESS(patterns[0]);
-	}
-	else if ((offset = patterns[1]->lastIndexIn(line)) >= 0)
-	{
-		NVENCC_UPDATE_PROGRESS_OLD(patterns[1]);
-	}
-	else if ((offset = patterns[2]->lastIndexIn(line)) >= 0)
+	LineParser::match_t match;
+	switch(parser.parse(line, match))
 	{
+	case 0:
+		NVENCC_UPDATE_BITRATE(match, 2, 5);
+		NVENCC_UPDATE_PROGRESS(match);
+		NVENCC_UPDATE_STATISTICS(match, 3, 6);
+		break;
+	case 1:
+		NVENCC_UPDATE_PROGRESS(match);
+		setStatistics(0.0, estimator.getRemainingTime());
+		break;
+	case 2:
+		NVENCC_UPDATE_PROGRESS_OLD(match);
+		setStatistics(0.0, estimator.getRemainingTime());
+		break;
+	case 3:
 		log(QString("ERROR: YOUR HARDWARE DOES *NOT* SUPPORT THE '%1' CODEC !!!\n").arg(s_nvencEncoderInfo.variantToString(m_options->encVariant())));
-	}
-	else if ((offset = patterns[3]->lastIndexIn(line)) >= 0)
-	{
+		break;
+	case 4:
 		log("ERROR: NVIDIA ENCODER API (NVENCODEAPI.DLL) IS *NOT* AVAILABLE !!!\n");
-	}
-	else if(!line.isEmpty())
-	{
+		break;
+	default:
 		log(line);
+		break;
 	}
 }
@@ -28,6 +28,8 @@
 #include "mediainfo.h"
 #include "model_sysinfo.h"
 #include "model_clipInfo.h"
+#include "line_parser.h"
+#include "size_estimator.h"
 
 //MUtils
 #include <MUtils/Global.h>
@@ -67,21 +69,28 @@ while(0)
 
 #define X264_UPDATE_PROGRESS(X) do \
 { \
-	bool ok[2] = { false, false }; \
-	unsigned int progressInt = (X)->cap(1).toUInt(&ok[0]); \
-	unsigned int progressFrc = (X)->cap(2).toUInt(&ok[1]); \
 	setStatus((pass == 2) ? JobStatus_Running_Pass2 : ((pass == 1) ? JobStatus_Running_Pass1 : JobStatus_Running)); \
-	if(ok[0] && ok[1]) \
+	const double progress = (double((X).values[0]) / 100.0) + (double((X).values[1]) / 1000.0); \
+	if(!qFuzzyCompare(progress, last_progress)) \
 	{ \
-		const double progress = (double(progressInt) / 100.0) + (double(progressFrc) / 1000.0); \
-		if(!qFuzzyCompare(progress, last_progress)) \
-		{ \
-			setProgress(floor(progress * 100.0)); \
-			size_estimate = qFuzzyIsNull(size_estimate) ? estimateSize(m_outputFile, progress) : ((0.667 * size_estimate) + (0.333 * estimateSize(m_outputFile, progress))); \
-			last_progress = progress; \
-		} \
+		setProgress(floor(progress * 100.0)); \
+		estimator.update(progress); \
+		last_progress = progress; \
 	} \
-	setDetails(tr("%1, est. file size %2").arg(line.mid(offset).trimmed(), sizeToString(qRound64(size_estimate)))); \
+	setDetails(tr("%1, est. file size %2").arg(QString::fromUtf8(line.latin1() + (X).offset), sizeToString(qRound64(estimator.getSize())))); \
+} \
+while(0)
+
+#define X264_UPDATE_BITRATE(X, FRAMES, KBPS) do \
+{ \
+	estimator.setBitrate((X).values[(FRAMES)], double((X).values[(KBPS)]) + (double((X).values[(KBPS) + 1]) / 100.0)); \
+} \
+while(0)
+
+#define X264_UPDATE_STATISTICS(X, FPS, ETA) do \
+{ \
+	const double fps = double((X).values[(FPS)]) + (double((X).values[(FPS) + 1]) / 100.0); \
+	setStatistics(fps, ((X).values[(ETA)] * 3600U) + ((X).values[(ETA) + 1] * 60U) + (X).values[(ETA) + 2]); \
 } \
 while(0)
 
@@ -232,8 +241,9 @@ void X264Encoder::checkVersion_init(QList<QRegExp*> &patterns, QStringList &cmdL
 	patterns << new QRegExp("\\bx264\\s+(\\d)\\.(\\d+)\\.(\\d+)", Qt::CaseInsensitive);
 }
 
-void X264Encoder::checkVersion_parseLine(const QString &line, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified)
+void X264Encoder::checkVersion_parseLine(const QLatin1String &rawLine, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified)
 {
+	const QString line = QString::fromUtf8(rawLine.latin1());
 	if(patterns[0]->lastIndexIn(line) >= 0)
 	{
 		unsigned int temp[3];
@@ -365,6 +375,20 @@ void X264Encoder::buildCommandLine(QStringList &cmdLine, const bool &usePipe, co
 		}
 	}
 
+	//Stay within the share of the processors of this job, unless overridden by the user
+	if(m_threadBudget > 0)
+	{
+		const unsigned int threads = qMax(1U, (m_threadBudget * 3U) / 2U);
+		if(!m_options->customEncParams().contains("--threads"))
+		{
+			cmdLine << "--threads" << QString::number(threads);
+		}
+		if(!m_options->customEncParams().contains("--lookahead-threads"))
+		{
+			cmdLine << "--lookahead-threads" << QString::number(qBound(1U, threads / 6U, 16U));
+		}
+	}
+
 	if(!m_options->customEncParams().isEmpty())
 	{
 		QStringList customArgs = splitParams(m_options->customEncParams(), m_sourceFile, m_outputFile);
@@ -386,58 +410,88 @@ void X264Encoder::buildCommandLine(QStringList &cmdLine, const bool &usePipe, co
 	
 	if(usePipe)
 	{
-		if (clipInfo.getFrameCount() < 1)
+		//Number of frames may not be known yet, if the clip properties are detected from the stream
+		if(clipInfo.getFrameCount() > 0)
 		{
-			MUTILS_THROW("Frames not set!");
+			cmdLine << "--frames" << QString::number(clipInfo.getFrameCount());
 		}
-		cmdLine << "--frames" << QString::number(clipInfo.getFrameCount());
 		cmdLine << "--demuxer" << "y4m";
 		cmdLine << "--stdin" << "y4m" << "-";
 	}
 	else
 	{
+		if(m_frameCount > 0)
+		{
+			cmdLine << "--seek" << QString::number(m_firstFrame);
+			cmdLine << "--frames" << QString::number(m_frameCount);
+		}
 		cmdLine << "--index" << QDir::toNativeSeparators(indexFile);
 		cmdLine << QDir::toNativeSeparators(m_sourceFile);
 	}
 }
 
-void X264Encoder::runEncodingPass_init(QList<QRegExp*> &patterns)
+bool X264Encoder::getIndexCommand(QString &program, QStringList &args) const
 {
-	patterns << new QRegExp("\\[(\\d+)\\.(\\d+)%\\].+frames");
-	patterns << new QRegExp("indexing.+\\[(\\d+)\\.(\\d+)%\\]");
-	patterns << new QRegExp("^(\\d+) frames:");
-	patterns << new QRegExp("\\[\\s*(\\d+)\\.(\\d+)%\\]\\s+(\\d+)/(\\d+)\\s(\\d+).(\\d+)\\s(\\d+).(\\d+)\\s+(\\d+):(\\d+):(\\d+)\\s+(\\d+):(\\d+):(\\d+)"); //regExpModified
-}
-
-void X264Encoder::runEncodingPass_parseLine(const QString &line, const QList<QRegExp*> &patterns, const ClipInfo &clipInfo, const int &pass, double &last_progress, double &size_estimate)
-{
-	int offset = -1;
-	if((offset = patterns[0]->lastIndexIn(line)) >= 0)
+	//Only native sources other than YUV4MPEG2 may be opened by the FFMS2 demuxer
+	if(MediaInfo::analyze(m_sourceFile) != MediaInfo::FILETYPE_UNKNOWN)
 	{
-		X264_UPDATE_PROGRESS(patterns[0]);
+		return false;
 	}
-	else if((offset = patterns[1]->lastIndexIn(line)) >= 0)
+
+	//Custom parameters could select a different demuxer or index file
+	if(m_options->customEncParams().contains("--demuxer") || m_options->customEncParams().contains("--index"))
 	{
-		bool ok = false;
-		unsigned int progress = patterns[1]->cap(1).toUInt(&ok);
-		setStatus(JobStatus_Indexing);
-		if(ok)
-		{
-			setProgress(progress);
-		}
-		setDetails(line.mid(offset).trimmed());
+		return false;
 	}
-	else if((offset = patterns[2]->lastIndexIn(line)) >= 0)
+
+	program = getBinaryPath();
+	args.clear();
+	args << "--frames" << "1";
+	args << "--index" << QDir::toNativeSeparators(m_indexFile);
+	args << "--output" << "NUL";
+	args << QDir::toNativeSeparators(m_sourceFile);
+	return true;
+}
+
+void X264Encoder::runEncodingPass_init(LineParser &parser)
+{
+	parser.addPattern("[%u.%u%%] %u/%u frames, %u.%u fps, %u.%u kb/s,%*eta %u:%u:%u"); //regExpStatus
+	parser.addPattern("[%u.%u%%]%*frames");   //regExpProgress
+	parser.addPattern("indexing%*[%u.%u%%]"); //regExpIndexing
+	parser.addPattern("^%u frames:");         //regExpFrameCnt
+	parser.addPattern("[%_%u.%u%%] %u/%u %u%?%u %u%?%u %u:%u:%u %u:%u:%u"); //regExpModified
+}
+
+void X264Encoder::runEncodingPass_parseLine(const QLatin1String &line, const LineParser &parser, const ClipInfo &clipInfo, const int &pass, double &last_progress, SizeEstimator &estimator)
+{
+	LineParser::match_t match;
+	switch(parser.parse(line, match))
 	{
+	case 0:
+		X264_UPDATE_BITRATE(match, 2, 6);
+		X264_UPDATE_PROGRESS(match);
+		X264_UPDATE_STATISTICS(match, 4, 8);
+		break;
+	case 1:
+		X264_UPDATE_PROGRESS(match);
+		setStatistics(0.0, estimator.getRemainingTime());
+		break;
+	case 4:
+		X264_UPDATE_BITRATE(match, 2, 6);
+		X264_UPDATE_PROGRESS(match);
+		X264_UPDATE_STATISTICS(match, 4, 11);
+		break;
+	case 2:
+		setStatus(JobStatus_Indexing);
+		setProgress(match.values[0]);
+		setDetails(QString::fromUtf8(line.latin1() + match.offset));
+		break;
+	case 3:
 		setStatus((pass == 2) ? JobStatus_Running_Pass2 : ((pass == 1) ? JobStatus_Running_Pass1 : JobStatus_Running));
-		setDetails(line.mid(offset).trimmed());
-	}
-	else if((offset = patterns[3]->lastIndexIn(line)) >= 0)
-	{
-		X264_UPDATE_PROGRESS(patterns[3]);
-	}
-	else if(!line.isEmpty())
-	{
+		setDetails(QString::fromUtf8(line.latin1() + match.offset));
+		break;
+	default:
 		log(line);
+		break;
 	}
 }
@@ -37,14 +37,16 @@ public:
 	virtual const AbstractEncoderInfo& getEncoderInfo(void) const;
 	static const AbstractEncoderInfo& encoderInfo(void);
 
+	virtual bool getIndexCommand(QString &program, QStringList &args) const;
+
 protected:
 	virtual QString getBinaryPath() const { return getEncoderInfo().getBinaryPath(m_sysinfo, m_options->encArch(), m_options->encVariant()); }
 	virtual void buildCommandLine(QStringList &cmdLine, const bool &usePipe, const ClipInfo &clipInfo, const QString &indexFile, const int &pass, const QString &passLogFile);
 
 	virtual void checkVersion_init(QList<QRegExp*> &patterns, QStringList &cmdLine);
-	virtual void checkVersion_parseLine(const QString &line, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified);
+	virtual void checkVersion_parseLine(const QLatin1String &rawLine, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified);
 
-	virtual void runEncodingPass_init(QList<QRegExp*> &patterns);
-	virtual void runEncodingPass_parseLine(const QString &line, const QList<QRegExp*> &patterns, const ClipInfo &clipInfo, const int &pass, double &last_progress, double &size_estimate);
+	virtual void runEncodingPass_init(LineParser &parser);
+	virtual void runEncodingPass_parseLine(const QLatin1String &line, const LineParser &parser, const ClipInfo &clipInfo, const int &pass, double &last_progress, SizeEstimator &estimator);
 
 };
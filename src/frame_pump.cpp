@@ -0,0 +1,430 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "frame_pump.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+//Qt
+#include <QProcess>
+
+//CRT
+#include <new>
+
+static const char *const Y4M_FRAME_MARKER = "FRAME\n";
+
+// ------------------------------------------------------------
+// Constructor & Destructor
+// ------------------------------------------------------------
+
+FramePump::FramePump(QProcess &processInput, QProcess &processEncode, const unsigned int &bufferFrames, const unsigned int &bufferLimit)
+:
+	m_processInput(processInput),
+	m_bufferFrames(bufferFrames),
+	m_bufferLimit(quint64(bufferLimit) << 20),
+	m_buffer(new char[m_bufferSize]),
+	m_capacity(m_bufferSize),
+	m_head(0),
+	m_used(0),
+	m_sourceDone(false),
+	m_bufferResized(false),
+	m_finished(false),
+	m_bytesTotal(0),
+	m_framesTotal(0),
+	m_elapsed(-1),
+	m_lastSample(0),
+	m_fillIntegral(0.0),
+	m_peakFill(0),
+	m_fullTime(0),
+	m_emptyTime(0),
+	m_parserState(STATE_HEADER),
+	m_payloadRemaining(0)
+{
+	memset(&m_streamInfo, 0, sizeof(MediaInfo::yuv4mpeg_t));
+	addConsumer(processEncode);
+}
+
+FramePump::~FramePump(void)
+{
+	MUTILS_DELETE_ARRAY(m_buffer);
+}
+
+// ------------------------------------------------------------
+// Consumers
+// ------------------------------------------------------------
+
+/*
+ * Every consumer (encoder process) receives the complete stream. Data is only released from the ring buffer
+ * once it has been forwarded to *all* consumers, so the slowest consumer applies backpressure to the source.
+ */
+
+void FramePump::addConsumer(QProcess &processEncode)
+{
+	consumer_t consumer;
+	consumer.process = &processEncode;
+	consumer.sent = 0;
+	m_consumers.append(consumer);
+}
+
+void FramePump::removeConsumer(QProcess &processEncode)
+{
+	for(QList<consumer_t>::Iterator iter = m_consumers.begin(); iter != m_consumers.end(); iter++)
+	{
+		if(iter->process == &processEncode)
+		{
+			m_consumers.erase(iter);
+			break;
+		}
+	}
+}
+
+// ------------------------------------------------------------
+// Transfer
+// ------------------------------------------------------------
+
+bool FramePump::transfer(const int &timeout)
+{
+	if(m_finished)
+	{
+		return false;
+	}
+
+	//Forward the buffered data, as far as the encoder is able to consume it
+	bool progress = drainBuffer();
+
+	//Read more data from the source, unless the buffer is full already
+	if((!m_sourceDone) && (m_used < m_capacity))
+	{
+		progress = fillBuffer((progress || (m_used > 0)) ? 0 : timeout) || progress;
+	}
+
+	//Nothing could be moved, so wait until the slowest encoder has consumed some data
+	if((!progress) && (m_used > 0))
+	{
+		QProcess *slowest = NULL;
+		qint64 minSent = m_used;
+		for(QList<consumer_t>::ConstIterator iter = m_consumers.constBegin(); iter != m_consumers.constEnd(); iter++)
+		{
+			if((iter->process->state() != QProcess::NotRunning) && (iter->sent <= minSent))
+			{
+				slowest = iter->process;
+				minSent = iter->sent;
+			}
+		}
+		if(slowest)
+		{
+			slowest->waitForBytesWritten(timeout);
+		}
+	}
+
+	updateStatistics();
+
+	if(m_sourceDone && (m_used < 1))
+	{
+		finish();
+	}
+
+	return progress;
+}
+
+bool FramePump::fillBuffer(const int &timeout)
+{
+	if(m_processInput.bytesAvailable() < 1)
+	{
+		if(!m_processInput.waitForReadyRead(timeout))
+		{
+			if((m_processInput.state() == QProcess::NotRunning) && (m_processInput.bytesAvailable() < 1))
+			{
+				m_sourceDone = true;
+			}
+			return false;
+		}
+	}
+
+	bool progress = false;
+
+	//Read directly into the free space of the ring buffer
+	while((m_used < m_capacity) && (m_processInput.bytesAvailable() > 0))
+	{
+		const qint64 tail = (m_head + m_used) % m_capacity;
+		const qint64 space = (tail >= m_head) ? (m_capacity - tail) : (m_head - tail);
+		const qint64 len = m_processInput.read(m_buffer + tail, space);
+		if(len <= 0)
+		{
+			break;
+		}
+		if(!m_timer.isValid())
+		{
+			m_timer.start();
+		}
+		parseStream(m_buffer + tail, len);
+		m_used += len;
+		m_bytesTotal += len;
+		progress = true;
+	}
+
+	//Grow the buffer, as soon as the frame size is known
+	if((m_bufferFrames > 0) && (!m_bufferResized) && hasStreamInfo())
+	{
+		resizeBuffer();
+	}
+
+	return progress;
+}
+
+bool FramePump::drainBuffer(void)
+{
+	bool progress = false;
+	qint64 release = m_used;
+
+	for(QList<consumer_t>::Iterator iter = m_consumers.begin(); iter != m_consumers.end(); iter++)
+	{
+		//A consumer that has gone away must not hold back the others
+		if(iter->process->state() == QProcess::NotRunning)
+		{
+			continue;
+		}
+		while((iter->sent < m_used) && (iter->process->bytesToWrite() < m_maxPendingBytes))
+		{
+			const qint64 pos = (m_head + iter->sent) % m_capacity;
+			const qint64 len = qMin(qMin(m_used - iter->sent, m_capacity - pos), m_bufferSize);
+			const qint64 written = iter->process->write(m_buffer + pos, len);
+			if(written <= 0)
+			{
+				break;
+			}
+			iter->sent += written;
+			progress = true;
+		}
+		release = qMin(release, iter->sent);
+	}
+
+	//Release the data that has been forwarded to all consumers
+	if(release > 0)
+	{
+		m_head = (m_head + release) % m_capacity;
+		m_used -= release;
+		for(QList<consumer_t>::Iterator iter = m_consumers.begin(); iter != m_consumers.end(); iter++)
+		{
+			iter->sent = qMax(iter->sent - release, 0I64);
+		}
+		progress = true;
+	}
+
+	if(m_used < 1)
+	{
+		m_head = 0;
+	}
+
+	return progress;
+}
+
+void FramePump::resizeBuffer(void)
+{
+	m_bufferResized = true;
+
+	quint64 capacity = qMax(quint64(m_bufferFrames) * getFrameBytes(), quint64(m_bufferSize));
+	if(m_bufferLimit > 0)
+	{
+		capacity = qMin(capacity, qMax(m_bufferLimit, quint64(m_bufferSize)));
+	}
+	if(capacity <= quint64(m_capacity))
+	{
+		return;
+	}
+
+	char *const buffer = new (std::nothrow) char[size_t(capacity)];
+	if(!buffer)
+	{
+		qWarning("[FramePump] Failed to allocate the frame buffer!");
+		return;
+	}
+
+	//Move the pending data to the new buffer
+	const qint64 first = qMin(m_used, m_capacity - m_head);
+	memcpy(buffer, m_buffer + m_head, size_t(first));
+	if(m_used > first)
+	{
+		memcpy(buffer + first, m_buffer, size_t(m_used - first));
+	}
+
+	MUTILS_DELETE_ARRAY(m_buffer);
+	m_buffer = buffer;
+	m_capacity = qint64(capacity);
+	m_head = 0;
+}
+
+void FramePump::finish(void)
+{
+	m_elapsed = m_timer.isValid() ? m_timer.elapsed() : 0;
+	for(QList<consumer_t>::ConstIterator iter = m_consumers.constBegin(); iter != m_consumers.constEnd(); iter++)
+	{
+		iter->process->closeWriteChannel();
+	}
+	m_finished = true;
+}
+
+// ------------------------------------------------------------
+// Statistics
+// ------------------------------------------------------------
+
+void FramePump::updateStatistics(void)
+{
+	if(!m_timer.isValid())
+	{
+		return;
+	}
+
+	const qint64 now = m_timer.elapsed();
+	const qint64 delta = now - m_lastSample;
+	if(delta > 0)
+	{
+		m_fillIntegral += static_cast<double>(m_used) * static_cast<double>(delta);
+		if(m_used >= m_capacity)
+		{
+			m_fullTime += delta;
+		}
+		else if((m_used < 1) && (!m_sourceDone))
+		{
+			m_emptyTime += delta;
+		}
+		m_lastSample = now;
+	}
+
+	m_peakFill = qMax(m_peakFill, m_used);
+}
+
+double FramePump::getElapsedTime(void) const
+{
+	const qint64 elapsed = (m_elapsed >= 0) ? m_elapsed : (m_timer.isValid() ? m_timer.elapsed() : 0);
+	return static_cast<double>(elapsed) / 1000.0;
+}
+
+double FramePump::getBytesPerSecond(void) const
+{
+	const double elapsed = getElapsedTime();
+	return (elapsed > 0.0) ? (static_cast<double>(m_bytesTotal) / elapsed) : 0.0;
+}
+
+double FramePump::getFramesPerSecond(void) const
+{
+	const double elapsed = getElapsedTime();
+	return (elapsed > 0.0) ? (static_cast<double>(m_framesTotal) / elapsed) : 0.0;
+}
+
+double FramePump::getBufferCapacity(void) const
+{
+	const quint64 frameBytes = getFrameBytes();
+	return (frameBytes > 0) ? (static_cast<double>(m_capacity) / static_cast<double>(frameBytes)) : 0.0;
+}
+
+double FramePump::getBufferAverageFill(void) const
+{
+	const quint64 frameBytes = getFrameBytes();
+	return ((frameBytes > 0) && (m_lastSample > 0)) ? ((m_fillIntegral / static_cast<double>(m_lastSample)) / static_cast<double>(frameBytes)) : 0.0;
+}
+
+double FramePump::getBufferPeakFill(void) const
+{
+	const quint64 frameBytes = getFrameBytes();
+	return (frameBytes > 0) ? (static_cast<double>(m_peakFill) / static_cast<double>(frameBytes)) : 0.0;
+}
+
+double FramePump::getBufferFullRatio(void) const
+{
+	return (m_lastSample > 0) ? (static_cast<double>(m_fullTime) / static_cast<double>(m_lastSample)) : 0.0;
+}
+
+double FramePump::getBufferEmptyRatio(void) const
+{
+	return (m_lastSample > 0) ? (static_cast<double>(m_emptyTime) / static_cast<double>(m_lastSample)) : 0.0;
+}
+
+quint64 FramePump::getFrameBytes(void) const
+{
+	return hasStreamInfo() ? (m_streamInfo.frameSize + strlen(Y4M_FRAME_MARKER)) : 0;
+}
+
+// ------------------------------------------------------------
+// YUV4MPEG2 Stream Parser
+// ------------------------------------------------------------
+
+void FramePump::parseStream(const char *data, const qint64 &len)
+{
+	qint64 pos = 0;
+	while(pos < len)
+	{
+		switch(m_parserState)
+		{
+		case STATE_HEADER:
+			{
+				const char *const eol = static_cast<const char*>(memchr(data + pos, '\n', size_t(len - pos)));
+				const qint64 count = eol ? ((eol - (data + pos)) + 1) : (len - pos);
+				m_header.append(data + pos, int(count));
+				pos += count;
+				if(eol)
+				{
+					const bool ok = MediaInfo::parseYuv4MpegHeader(m_header.constData(), m_header.size(), m_streamInfo);
+					m_parserState = ok ? STATE_FRAME_HEADER : STATE_INVALID;
+					if(!ok) qWarning("[FramePump] Failed to parse YUV4MPEG2 stream header!");
+				}
+				else if(m_header.size() > m_maxHeaderSize)
+				{
+					qWarning("[FramePump] YUV4MPEG2 stream header is too long!");
+					m_parserState = STATE_INVALID;
+				}
+			}
+			break;
+		case STATE_FRAME_HEADER:
+			{
+				const char *const eol = static_cast<const char*>(memchr(data + pos, '\n', size_t(len - pos)));
+				if(eol)
+				{
+					pos = (eol - data) + 1;
+					m_payloadRemaining = m_streamInfo.frameSize;
+					m_parserState = STATE_PAYLOAD;
+				}
+				else
+				{
+					pos = len;
+				}
+			}
+			break;
+		case STATE_PAYLOAD:
+			{
+				const quint64 count = qMin(m_payloadRemaining, quint64(len - pos));
+				m_payloadRemaining -= count;
+				pos += count;
+				if(m_payloadRemaining < 1)
+				{
+					m_framesTotal++;
+					m_parserState = STATE_FRAME_HEADER;
+				}
+			}
+			break;
+		default:
+			pos = len;
+			break;
+		}
+	}
+}
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "mediainfo.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+
+class QProcess;
+
+class FramePump
+{
+public:
+	FramePump(QProcess &processInput, QProcess &processEncode, const unsigned int &bufferFrames = 0, const unsigned int &bufferLimit = 0);
+	~FramePump(void);
+
+	void addConsumer(QProcess &processEncode);
+	void removeConsumer(QProcess &processEncode);
+
+	bool transfer(const int &timeout);
+	bool isFinished(void) const { return m_finished; }
+
+	quint64 getBytesTransferred(void) const { return m_bytesTotal; }
+	quint64 getFramesTransferred(void) const { return m_framesTotal; }
+	bool hasStreamInfo(void) const { return (m_parserState == STATE_FRAME_HEADER) || (m_parserState == STATE_PAYLOAD); }
+	const MediaInfo::yuv4mpeg_t &getStreamInfo(void) const { return m_streamInfo; }
+
+	double getElapsedTime(void) const;
+	double getBytesPerSecond(void) const;
+	double getFramesPerSecond(void) const;
+
+	bool hasFrameBuffer(void) const { return m_bufferFrames > 0; }
+	double getBufferCapacity(void) const;
+	double getBufferAverageFill(void) const;
+	double getBufferPeakFill(void) const;
+	double getBufferFullRatio(void) const;
+	double getBufferEmptyRatio(void) const;
+
+	static const int m_transferInterval = 25;
+
+protected:
+	static const qint64 m_bufferSize = 1048576I64;
+	static const qint64 m_maxPendingBytes = 4I64 * m_bufferSize;
+	static const int m_maxHeaderSize = 4096;
+
+	typedef struct
+	{
+		QProcess *process;
+		qint64 sent;
+	}
+	consumer_t;
+
+	typedef enum
+	{
+		STATE_HEADER       = 0,
+		STATE_FRAME_HEADER = 1,
+		STATE_PAYLOAD      = 2,
+		STATE_INVALID      = 3
+	}
+	parserState_t;
+
+	bool fillBuffer(const int &timeout);
+	bool drainBuffer(void);
+	void resizeBuffer(void);
+	void updateStatistics(void);
+	void finish(void);
+	void parseStream(const char *data, const qint64 &len);
+	quint64 getFrameBytes(void) const;
+
+	QProcess &m_processInput;
+	QList<consumer_t> m_consumers;
+
+	const unsigned int m_bufferFrames;
+	const quint64 m_bufferLimit;
+
+	char *m_buffer;
+	qint64 m_capacity;
+	qint64 m_head;
+	qint64 m_used;
+	bool m_sourceDone;
+	bool m_bufferResized;
+	bool m_finished;
+
+	quint64 m_bytesTotal;
+	quint64 m_framesTotal;
+	QElapsedTimer m_timer;
+	qint64 m_elapsed;
+
+	qint64 m_lastSample;
+	double m_fillIntegral;
+	qint64 m_peakFill;
+	qint64 m_fullTime;
+	qint64 m_emptyTime;
+
+	int m_parserState;
+	QByteArray m_header;
+	MediaInfo::yuv4mpeg_t m_streamInfo;
+	quint64 m_payloadRemaining;
+};
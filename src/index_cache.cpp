@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "index_cache.h"
+
+//Internal
+#include "global.h"
+
+//Qt
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutex>
+#include <QCryptographicHash>
+
+//CRT
+#include <sys/utime.h>
+
+/*
+ * Index files of the FFMS2 demuxer are kept in a persistent cache directory. The name of the index file is
+ * derived from the path, the size and the modification time of the source file, so that an index is re-used
+ * for as long as the source file is unchanged. The modification time of the index file serves as the time of
+ * its last use, the least recently used index files are evicted once the size of the cache exceeds the quota.
+ * Index files that are still in use by an encoder can not be deleted (on Windows), so they are skipped.
+ */
+
+static const char *const INDEX_SUFFIX = "ffindex";
+
+static QMutex g_indexCacheMutex;
+
+QString IndexCache::getIndexFile(const QString &sourceFile)
+{
+	const QFileInfo sourceInfo(sourceFile);
+	const QString key = QString("%1|%2|%3").arg(QDir::cleanPath(sourceInfo.absoluteFilePath()).toLower(), QString::number(sourceInfo.size()), QString::number(sourceInfo.lastModified().toMSecsSinceEpoch()));
+	const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+	return QString("%1/%2.%3").arg(getCacheDir(), QString::fromLatin1(hash.toHex().constData()), QString::fromLatin1(INDEX_SUFFIX));
+}
+
+void IndexCache::touch(const QString &indexFile)
+{
+	QMutexLocker lock(&g_indexCacheMutex);
+	if(QFileInfo(indexFile).isFile())
+	{
+		_wutime(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(indexFile).utf16()), NULL);
+	}
+}
+
+void IndexCache::evict(const quint64 &quota)
+{
+	QMutexLocker lock(&g_indexCacheMutex);
+
+	const QFileInfoList files = QDir(getCacheDir()).entryInfoList(QStringList() << QString("*.%1").arg(QString::fromLatin1(INDEX_SUFFIX)), QDir::Files, QDir::Time);
+	quint64 totalSize = 0;
+
+	//The list is sorted by time, most recently used files first
+	for(QFileInfoList::ConstIterator iter = files.constBegin(); iter != files.constEnd(); iter++)
+	{
+		totalSize += quint64(iter->size());
+		if(totalSize > quota)
+		{
+			if(QFile::remove(iter->absoluteFilePath()))
+			{
+				totalSize -= quint64(iter->size());
+			}
+		}
+	}
+}
+
+QString IndexCache::getCacheDir(void)
+{
+	static QMutex mutex;
+	static QString cacheDir;
+
+	QMutexLocker lock(&mutex);
+	if(cacheDir.isEmpty())
+	{
+		const QString path = QString("%1/cache/index").arg(x264_data_path());
+		cacheDir = QDir().mkpath(path) ? path : QDir::tempPath();
+	}
+
+	return cacheDir;
+}
@@ -108,6 +108,62 @@ bool JobObject::addProcessToJob(const QProcess *proc)
 	}
 }
 
+bool JobObject::setAffinity(const quint64 &mask)
+{
+	if(!m_hJobObject)
+	{
+		qWarning("Cannot set job affinity: No job bject available!");
+		return false;
+	}
+
+	JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobExtendedLimitInfo;
+	memset(&jobExtendedLimitInfo, 0, sizeof(JOBOBJECT_EXTENDED_LIMIT_INFORMATION));
+	if(!QueryInformationJobObject(m_hJobObject, JobObjectExtendedLimitInformation, &jobExtendedLimitInfo, sizeof(JOBOBJECT_EXTENDED_LIMIT_INFORMATION), NULL))
+	{
+		qWarning("Failed to query job object information!");
+		return false;
+	}
+
+	//A mask of zero removes the restriction again
+	if(mask)
+	{
+		jobExtendedLimitInfo.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_AFFINITY;
+		jobExtendedLimitInfo.BasicLimitInformation.Affinity = static_cast<ULONG_PTR>(mask);
+	}
+	else
+	{
+		jobExtendedLimitInfo.BasicLimitInformation.LimitFlags &= (~JOB_OBJECT_LIMIT_AFFINITY);
+		jobExtendedLimitInfo.BasicLimitInformation.Affinity = 0;
+	}
+
+	if(!SetInformationJobObject(m_hJobObject, JobObjectExtendedLimitInformation, &jobExtendedLimitInfo, sizeof(JOBOBJECT_EXTENDED_LIMIT_INFORMATION)))
+	{
+		qWarning("Failed to set job object affinity!");
+		return false;
+	}
+
+	return true;
+}
+
+quint64 JobObject::getPeakMemoryUsage(void)
+{
+	if(!m_hJobObject)
+	{
+		qWarning("Cannot query job memory usage: No job bject available!");
+		return 0;
+	}
+
+	JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobExtendedLimitInfo;
+	memset(&jobExtendedLimitInfo, 0, sizeof(JOBOBJECT_EXTENDED_LIMIT_INFORMATION));
+	if(!QueryInformationJobObject(m_hJobObject, JobObjectExtendedLimitInformation, &jobExtendedLimitInfo, sizeof(JOBOBJECT_EXTENDED_LIMIT_INFORMATION), NULL))
+	{
+		qWarning("Failed to query job object information!");
+		return 0;
+	}
+
+	return static_cast<quint64>(jobExtendedLimitInfo.PeakJobMemoryUsed);
+}
+
 bool JobObject::terminateJob(unsigned int exitCode)
 {
 	if(m_hJobObject)
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <QtGlobal>
+
 class QProcess;
 
 class JobObject
@@ -32,6 +34,8 @@ public:
 
 	bool addProcessToJob(const QProcess *proc);
 	bool terminateJob(unsigned int exitCode = -1);
+	bool setAffinity(const quint64 &mask);
+	quint64 getPeakMemoryUsage(void);
 
 private:
 	void *m_hJobObject;
@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "job_scheduler.h"
+
+//CRT
+#include <algorithm>
+
+/*
+ * The scheduler decides which enqueued job is started next. Every submitter has a queue of its own, which is a
+ * binary heap ordered by priority and then by arrival. The submitters are kept in another binary heap, which
+ * is ordered by the priority of their foremost job and then by their virtual time. The virtual time advances
+ * by 1/weight whenever a job of the submitter is started, so submitters of the same priority get their share
+ * of the job slots in proportion to their weight, regardless of how many jobs each of them has enqueued. The
+ * submitter heap is updated lazily: every change of a submitter issues a new ticket, outdated tickets are
+ * dropped when they come up. Likewise, jobs that leave the queue by other means (started by the user or
+ * deleted) are only marked as removed; they are dropped as soon as they reach the top of their queue, so
+ * the queues never have to be searched and the tickets always refer to a job that is still enqueued.
+ */
+
+static const double MIN_WEIGHT = 0.01;
+static const double MAX_WEIGHT = 100.0;
+static const int TICKET_SLACK = 64;
+
+JobScheduler::JobScheduler(void)
+:
+	m_virtualTime(0.0),
+	m_sequence(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public interface
+///////////////////////////////////////////////////////////////////////////////
+
+quint64 JobScheduler::enqueue(const QUuid &jobId, const QString &submitter, const int &priority)
+{
+	const entry_t entry = { priority, m_sequence++, jobId };
+	push(submitter, entry);
+	return entry.sequence;
+}
+
+void JobScheduler::requeue(const QUuid &jobId, const QString &submitter, const int &priority, const quint64 &sequence)
+{
+	const entry_t entry = { priority, sequence, jobId };
+	push(submitter, entry);
+}
+
+bool JobScheduler::takeNext(QUuid &jobId)
+{
+	while(!m_tickets.isEmpty())
+	{
+		std::pop_heap(m_tickets.begin(), m_tickets.end(), lessTicket);
+		const ticket_t ticket = m_tickets.last();
+		m_tickets.removeLast();
+
+		QHash<QString, submitter_t>::Iterator iter = m_submitters.find(ticket.submitter);
+		if((iter == m_submitters.end()) || (iter->version != ticket.version) || iter->queue.isEmpty())
+		{
+			continue; /*outdated ticket*/
+		}
+
+		std::pop_heap(iter->queue.begin(), iter->queue.end(), lessEntry);
+		jobId = iter->queue.last().jobId;
+		iter->queue.removeLast();
+
+		m_virtualTime = qMax(m_virtualTime, iter->virtualTime);
+		publish(ticket.submitter, iter.value());
+		return true;
+	}
+
+	return false;
+}
+
+void JobScheduler::remove(const QUuid &jobId, const QString &submitter)
+{
+	QHash<QString, submitter_t>::Iterator iter = m_submitters.find(submitter);
+	if(iter != m_submitters.end())
+	{
+		m_removed.insert(jobId);
+		if((!iter->queue.isEmpty()) && (iter->queue.first().jobId == jobId))
+		{
+			publish(submitter, iter.value());
+		}
+	}
+}
+
+void JobScheduler::clear(void)
+{
+	for(QHash<QString, submitter_t>::Iterator iter = m_submitters.begin(); iter != m_submitters.end(); iter++)
+	{
+		iter->queue.clear();
+		iter->version++;
+	}
+	m_tickets.clear();
+	m_removed.clear();
+}
+
+void JobScheduler::charge(const QString &submitter)
+{
+	submitter_t &state = getSubmitter(submitter);
+	state.virtualTime = qMax(state.virtualTime, m_virtualTime) + (1.0 / state.weight);
+	publish(submitter, state);
+}
+
+void JobScheduler::setWeight(const QString &submitter, const double &weight)
+{
+	getSubmitter(submitter).weight = qBound(MIN_WEIGHT, weight, MAX_WEIGHT);
+}
+
+double JobScheduler::getVirtualTime(const QString &submitter) const
+{
+	QHash<QString, submitter_t>::ConstIterator iter = m_submitters.constFind(submitter);
+	return (iter != m_submitters.constEnd()) ? qMax(iter->virtualTime, m_virtualTime) : m_virtualTime;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+void JobScheduler::push(const QString &name, const entry_t &entry)
+{
+	submitter_t &state = getSubmitter(name);
+
+	//A submitter that has been idle does not get credit for the time it was idle
+	if(state.queue.isEmpty())
+	{
+		state.virtualTime = qMax(state.virtualTime, m_virtualTime);
+	}
+
+	const bool foremost = state.queue.isEmpty() || lessEntry(state.queue.first(), entry);
+	state.queue.append(entry);
+	std::push_heap(state.queue.begin(), state.queue.end(), lessEntry);
+
+	if(foremost)
+	{
+		publish(name, state);
+	}
+}
+
+void JobScheduler::publish(const QString &name, submitter_t &submitter)
+{
+	//Drop the removed jobs from the top of the queue
+	while((!submitter.queue.isEmpty()) && m_removed.remove(submitter.queue.first().jobId))
+	{
+		std::pop_heap(submitter.queue.begin(), submitter.queue.end(), lessEntry);
+		submitter.queue.removeLast();
+	}
+
+	submitter.version++;
+
+	//Drop the outdated tickets, once they outnumber the valid ones by far
+	if(m_tickets.count() > (2 * m_submitters.count()) + TICKET_SLACK)
+	{
+		m_tickets.clear();
+		for(QHash<QString, submitter_t>::ConstIterator iter = m_submitters.constBegin(); iter != m_submitters.constEnd(); iter++)
+		{
+			if((iter.key() != name) && (!iter->queue.isEmpty()))
+			{
+				const ticket_t ticket = { iter->queue.first().priority, iter->virtualTime, iter->queue.first().sequence, iter->version, iter.key() };
+				m_tickets.append(ticket);
+			}
+		}
+		std::make_heap(m_tickets.begin(), m_tickets.end(), lessTicket);
+	}
+
+	if(!submitter.queue.isEmpty())
+	{
+		const ticket_t ticket = { submitter.queue.first().priority, submitter.virtualTime, submitter.queue.first().sequence, submitter.version, name };
+		m_tickets.append(ticket);
+		std::push_heap(m_tickets.begin(), m_tickets.end(), lessTicket);
+	}
+}
+
+JobScheduler::submitter_t &JobScheduler::getSubmitter(const QString &name)
+{
+	QHash<QString, submitter_t>::Iterator iter = m_submitters.find(name);
+	if(iter == m_submitters.end())
+	{
+		submitter_t submitter;
+		submitter.weight = 1.0;
+		submitter.virtualTime = m_virtualTime;
+		submitter.version = 0;
+		iter = m_submitters.insert(name, submitter);
+	}
+	return iter.value();
+}
+
+/*
+ * Both heaps are max-heaps: higher priority first, then lower virtual time, then earlier arrival
+ */
+bool JobScheduler::lessEntry(const entry_t &a, const entry_t &b)
+{
+	if(a.priority != b.priority)
+	{
+		return a.priority < b.priority;
+	}
+	return a.sequence > b.sequence;
+}
+
+bool JobScheduler::lessTicket(const ticket_t &a, const ticket_t &b)
+{
+	if(a.priority != b.priority)
+	{
+		return a.priority < b.priority;
+	}
+	if(a.virtualTime != b.virtualTime)
+	{
+		return a.virtualTime > b.virtualTime;
+	}
+	return a.sequence > b.sequence;
+}
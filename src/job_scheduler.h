@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QUuid>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+
+#if QT_VERSION < 0x050000
+inline uint qHash(const QUuid &uuid)
+{
+	return uuid.data1 ^ ((uint(uuid.data2) << 16) | uint(uuid.data3)) ^
+		((uint(uuid.data4[0]) << 24) | (uint(uuid.data4[1]) << 16) | (uint(uuid.data4[2]) << 8) | uint(uuid.data4[3])) ^
+		((uint(uuid.data4[4]) << 24) | (uint(uuid.data4[5]) << 16) | (uint(uuid.data4[6]) << 8) | uint(uuid.data4[7]));
+}
+#endif
+
+class JobScheduler
+{
+public:
+	JobScheduler(void);
+
+	quint64 enqueue(const QUuid &jobId, const QString &submitter, const int &priority);
+	void requeue(const QUuid &jobId, const QString &submitter, const int &priority, const quint64 &sequence);
+	bool takeNext(QUuid &jobId);
+	void remove(const QUuid &jobId, const QString &submitter);
+	void clear(void);
+	void charge(const QString &submitter);
+	void setWeight(const QString &submitter, const double &weight);
+	double getVirtualTime(const QString &submitter) const;
+
+private:
+	typedef struct
+	{
+		int priority;
+		quint64 sequence;
+		QUuid jobId;
+	}
+	entry_t;
+
+	typedef struct
+	{
+		QVector<entry_t> queue;
+		double weight;
+		double virtualTime;
+		quint32 version;
+	}
+	submitter_t;
+
+	typedef struct
+	{
+		int priority;
+		double virtualTime;
+		quint64 sequence;
+		quint32 version;
+		QString submitter;
+	}
+	ticket_t;
+
+	QHash<QString, submitter_t> m_submitters;
+	QVector<ticket_t> m_tickets;
+	QSet<QUuid> m_removed;
+	double m_virtualTime;
+	quint64 m_sequence;
+
+	void push(const QString &name, const entry_t &entry);
+	void publish(const QString &name, submitter_t &submitter);
+	submitter_t &getSubmitter(const QString &name);
+
+	static bool lessEntry(const entry_t &a, const entry_t &b);
+	static bool lessTicket(const ticket_t &a, const ticket_t &b);
+};
@@ -0,0 +1,368 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "line_parser.h"
+
+//MUtils
+#include <MUtils/Global.h>
+#include <MUtils/Exception.h>
+
+//Qt
+#if defined(_DEBUG)
+#include <QRegExp>
+#include <QElapsedTimer>
+#endif
+
+/*
+ * Pattern syntax:
+ *
+ *   ^   Pattern must match at the beginning of the line (first character only)
+ *   %u  Unsigned decimal number, the value is captured
+ *   %_  Optional single space character
+ *   %?  Any single character
+ *   %*  Any non-empty sequence of characters (shortest match first, i.e. *not* greedy)
+ *   %%  Literal percent sign
+ *
+ * All other characters match literally. Since the line splitter has collapsed all white-spaces
+ * already, a single space in the pattern takes the role of "\s+" in a regular expression.
+ */
+
+static inline char LOWER(const char c)
+{
+	return ((c >= 'A') && (c <= 'Z')) ? (c + ('a' - 'A')) : c;
+}
+
+static inline bool IS_DIGIT(const char c)
+{
+	return (c >= '0') && (c <= '9');
+}
+
+// ------------------------------------------------------------
+// Constructor & Destructor
+// ------------------------------------------------------------
+
+LineParser::LineParser(void)
+{
+	/*Nothing to do here*/
+}
+
+LineParser::~LineParser(void)
+{
+	/*Nothing to do here*/
+}
+
+// ------------------------------------------------------------
+// Compile Pattern
+// ------------------------------------------------------------
+
+void LineParser::addPattern(const char *const pattern, const bool &caseSensitive)
+{
+	pattern_t compiled;
+	compiled.anchored = (pattern[0] == '^');
+	compiled.caseSensitive = caseSensitive;
+	compiled.first = m_tokens.count();
+
+	int captures = 0;
+	for(const char *ptr = compiled.anchored ? (pattern + 1) : pattern; *ptr; ptr++)
+	{
+		token_t token;
+		token.type = TOKEN_CHAR;
+		token.value = caseSensitive ? (*ptr) : LOWER(*ptr);
+		if(*ptr == '%')
+		{
+			switch(*(++ptr))
+			{
+			case 'u':
+				token.type = TOKEN_UINT;
+				if(++captures > MAX_CAPTURES)
+				{
+					MUTILS_THROW("Too many captures in line pattern!");
+				}
+				break;
+			case '_':
+				token.type = TOKEN_SPACE;
+				break;
+			case '?':
+				token.type = TOKEN_ANY;
+				break;
+			case '*':
+				token.type = TOKEN_SKIP;
+				break;
+			case '%':
+				token.value = '%';
+				break;
+			default:
+				MUTILS_THROW("Invalid escape sequence in line pattern!");
+			}
+		}
+		m_tokens.append(token);
+	}
+
+	compiled.count = m_tokens.count() - compiled.first;
+	m_patterns.append(compiled);
+}
+
+// ------------------------------------------------------------
+// Parse Line
+// ------------------------------------------------------------
+
+int LineParser::parse(const QLatin1String &line, match_t &match) const
+{
+	const char *const text = line.latin1();
+	const int len = int(strlen(text));
+
+	for(int index = 0; index < m_patterns.count(); index++)
+	{
+		const pattern_t &pattern = m_patterns.at(index);
+		const token_t &head = m_tokens.at(pattern.first);
+
+		//Try the right-most start position first, just like QRegExp::lastIndexIn() does
+		for(int start = pattern.anchored ? 0 : (len - 1); start >= 0; start--)
+		{
+			if((head.type == TOKEN_CHAR) && (head.value != (pattern.caseSensitive ? text[start] : LOWER(text[start]))))
+			{
+				continue;
+			}
+			match.count = 0;
+			if(matchAt(pattern, 0, text, len, start, match))
+			{
+				match.offset = start;
+				return index;
+			}
+		}
+	}
+
+	return -1;
+}
+
+bool LineParser::matchAt(const pattern_t &pattern, const int &index, const char *const line, const int &len, int pos, match_t &match) const
+{
+	for(int i = index; i < pattern.count; i++)
+	{
+		const token_t &token = m_tokens.at(pattern.first + i);
+		switch(token.type)
+		{
+		case TOKEN_CHAR:
+			if((pos >= len) || (token.value != (pattern.caseSensitive ? line[pos] : LOWER(line[pos]))))
+			{
+				return false;
+			}
+			pos++;
+			break;
+		case TOKEN_UINT:
+			{
+				if((pos >= len) || (!IS_DIGIT(line[pos])))
+				{
+					return false;
+				}
+				quint64 value = 0;
+				while((pos < len) && IS_DIGIT(line[pos]))
+				{
+					value = qMin((value * 10U) + quint64(line[pos++] - '0'), quint64(UINT_MAX));
+				}
+				match.values[match.count++] = quint32(value);
+			}
+			break;
+		case TOKEN_SPACE:
+			if((pos < len) && (line[pos] == ' '))
+			{
+				pos++;
+			}
+			break;
+		case TOKEN_ANY:
+			if(pos >= len)
+			{
+				return false;
+			}
+			pos++;
+			break;
+		case TOKEN_SKIP:
+			{
+				//Try all possible lengths, but keep the captures made so far
+				const int captures = match.count;
+				for(int next = pos + 1; next <= len; next++)
+				{
+					match.count = captures;
+					if(matchAt(pattern, i + 1, line, len, next, match))
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// ------------------------------------------------------------
+// Benchmark (debug builds only)
+// ------------------------------------------------------------
+
+#if defined(_DEBUG)
+
+/*
+ * Lines recorded from x264, x265 and NVEncC, already in the form they take after the line splitter
+ */
+static const char *const BENCH_LINES_X264[] =
+{
+	"[12.3%] 1234/10000 frames, 45.67 fps, 1234.56 kb/s, eta 0:03:12",
+	"[ 98.7%] 9870/10000 45.67 3210.98 0:03:36 0:00:02",
+	"indexing input file [45.6%]",
+	"x264 [info]: using cpu capabilities: MMX2 SSE2Fast SSSE3 SSE4.2 AVX FMA3 BMI2 AVX2",
+	"x264 [info]: profile High, level 4.1",
+	"y4m [info]: 1920x1080p 1:1 @ 24000/1001 fps (cfr)",
+	"encoded 10000 frames, 45.67 fps, 1234.56 kb/s",
+	"10000 frames: 45.67 fps, 1234.56 kb/s",
+	NULL
+};
+
+static const char *const BENCH_LINES_NVENC[] =
+{
+	"[12.3%] 1234 frames: 145.67 fps, 5123 kb/s, remain 0:01:12",
+	"NVEncC (x64) 3.08 (r1267) by rigaya, Feb 2 2017 22:27:48 (VC 1900/Win/avx2)",
+	"Selected codec is not supported",
+	"nvEncodeAPI.dll does not exists in your system",
+	"encoded 10000 frames, 145.67 fps, 5123.45 kbps, 180.12 MB",
+	NULL
+};
+
+/*
+ * The LineParser patterns and the QRegExp chain they replaced (in the order the old code applied them)
+ */
+static const char *const BENCH_PATTERNS_X264[] =
+{
+	"[%u.%u%%]%*frames",
+	"indexing%*[%u.%u%%]",
+	"^%u frames:",
+	"[%_%u.%u%%] %u/%u %u%?%u %u%?%u %u:%u:%u %u:%u:%u",
+	NULL
+};
+
+static const char *const BENCH_REGEXPS_X264[] =
+{
+	"\\[(\\d+)\\.(\\d+)%\\].+frames",
+	"indexing.+\\[(\\d+)\\.(\\d+)%\\]",
+	"^(\\d+) frames:",
+	"\\[\\s*(\\d+)\\.(\\d+)%\\]\\s+(\\d+)/(\\d+)\\s(\\d+).(\\d+)\\s(\\d+).(\\d+)\\s+(\\d+):(\\d+):(\\d+)\\s+(\\d+):(\\d+):(\\d+)",
+	NULL
+};
+
+static const char *const BENCH_PATTERNS_NVENC[] =
+{
+	"[%u.%u%%]%*frames",
+	"^%u frames:",
+	"Selected codec is not supported",
+	"nvEncodeAPI.dll does not exists in your system",
+	NULL
+};
+
+static const char *const BENCH_REGEXPS_NVENC[] =
+{
+	"\\[(\\d+)\\.(\\d+)%\\].+frames",
+	"^(\\d+) frames:",
+	"Selected\\s+codec\\s+is\\s+not\\s+supported",
+	"nvEncodeAPI.dll\\s+does\\s+not\\s+exists\\s+in\\s+your\\s+system",
+	NULL
+};
+
+static void benchmarkSet(const char *const name, const char *const *const lines, const char *const *const patterns, const char *const *const regExps, const bool caseSensitive, const unsigned int &iterations)
+{
+	LineParser parser;
+	for(const char *const *pattern = patterns; *pattern; pattern++)
+	{
+		parser.addPattern(*pattern, caseSensitive);
+	}
+
+	QList<QRegExp*> regExpList;
+	for(const char *const *regExp = regExps; *regExp; regExp++)
+	{
+		regExpList << new QRegExp(QLatin1String(*regExp), caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+	}
+
+	//Make sure both agree on which lines match, before measuring anything
+	unsigned int lineCount = 0;
+	for(const char *const *line = lines; *line; line++, lineCount++)
+	{
+		LineParser::match_t match;
+		const bool parserMatch = (parser.parse(QLatin1String(*line), match) >= 0);
+		bool regExpMatch = false;
+		for(QList<QRegExp*>::ConstIterator iter = regExpList.constBegin(); (iter != regExpList.constEnd()) && (!regExpMatch); iter++)
+		{
+			regExpMatch = ((*iter)->lastIndexIn(QString::fromLatin1(*line)) >= 0);
+		}
+		if(parserMatch != regExpMatch)
+		{
+			qWarning("[LineParser] Mismatch on line \"%s\" (LineParser=%d, QRegExp=%d)", *line, int(parserMatch), int(regExpMatch));
+		}
+	}
+
+	QElapsedTimer timer;
+	unsigned int hits = 0;
+
+	timer.start();
+	for(unsigned int i = 0; i < iterations; i++)
+	{
+		for(const char *const *line = lines; *line; line++)
+		{
+			LineParser::match_t match;
+			if(parser.parse(QLatin1String(*line), match) >= 0)
+			{
+				hits++;
+			}
+		}
+	}
+	const qint64 elapsedParser = timer.nsecsElapsed();
+
+	timer.restart();
+	for(unsigned int i = 0; i < iterations; i++)
+	{
+		for(const char *const *line = lines; *line; line++)
+		{
+			const QString text = QString::fromLatin1(*line);
+			for(QList<QRegExp*>::ConstIterator iter = regExpList.constBegin(); iter != regExpList.constEnd(); iter++)
+			{
+				if((*iter)->lastIndexIn(text) >= 0)
+				{
+					hits++;
+					break;
+				}
+			}
+		}
+	}
+	const qint64 elapsedRegExp = timer.nsecsElapsed();
+
+	qDeleteAll(regExpList);
+
+	const double total = double(iterations) * double(qMax(lineCount, 1U));
+	qDebug("[LineParser] %s: LineParser %.1f ns/line, QRegExp %.1f ns/line, speed-up %.2fx (%u hits)", name, double(elapsedParser) / total, double(elapsedRegExp) / total, double(elapsedRegExp) / double(qMax(elapsedParser, qint64(1))), hits);
+}
+
+void LineParser::benchmark(const unsigned int &iterations)
+{
+	qDebug("[LineParser] Running benchmark, %u iterations per line", iterations);
+	benchmarkSet("x264/x265", BENCH_LINES_X264, BENCH_PATTERNS_X264, BENCH_REGEXPS_X264, true,  iterations);
+	benchmarkSet("NVEncC",    BENCH_LINES_NVENC, BENCH_PATTERNS_NVENC, BENCH_REGEXPS_NVENC, false, iterations);
+}
+
+#endif //_DEBUG
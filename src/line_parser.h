@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+/*
+ * Note: The "%*" wildcard matches the *shortest* non-empty run of characters that allows the rest
+ * of the pattern to match, whereas the ".+" of the QRegExp patterns it replaces was greedy. Both
+ * agree on whether a line matches, but when porting a pattern whose captures follow a ".+", make
+ * sure the literal text after "%*" is unique in the line, or the captures will come from its first
+ * occurrence rather than its last one.
+ */
+class LineParser
+{
+public:
+	static const int MAX_CAPTURES = 16;
+
+	typedef struct
+	{
+		int offset;
+		int count;
+		quint32 values[MAX_CAPTURES];
+	}
+	match_t;
+
+	LineParser(void);
+	~LineParser(void);
+
+	void addPattern(const char *const pattern, const bool &caseSensitive = true);
+	int parse(const QLatin1String &line, match_t &match) const;
+
+#if defined(_DEBUG)
+	static void benchmark(const unsigned int &iterations);
+#endif
+
+protected:
+	typedef enum
+	{
+		TOKEN_CHAR  = 0,
+		TOKEN_UINT  = 1,
+		TOKEN_SPACE = 2,
+		TOKEN_ANY   = 3,
+		TOKEN_SKIP  = 4
+	}
+	tokenType_t;
+
+	typedef struct
+	{
+		int type;
+		char value;
+	}
+	token_t;
+
+	typedef struct
+	{
+		bool anchored;
+		bool caseSensitive;
+		int first;
+		int count;
+	}
+	pattern_t;
+
+	bool matchAt(const pattern_t &pattern, const int &index, const char *const line, const int &len, int pos, match_t &match) const;
+
+	QVector<token_t> m_tokens;
+	QVector<pattern_t> m_patterns;
+};
@@ -25,6 +25,7 @@
 #include "cli.h"
 #include "ipc.h"
 #include "thread_ipc_send.h"
+#include "line_parser.h"
 
 //MUtils
 #include <MUtils/Startup.h>
@@ -145,6 +146,15 @@ static int simple_x264_main(int &argc, char **argv)
 	qDebug("CPU capabilities  :  SSE4.1=%s, SSE4.2=%s, AVX=%s, AVX2=%s, FMA3=%s, LZCNT=%s", MUTILS_BOOL2STR(cpuFeatures.features & MUtils::CPUFetaures::FLAG_SSE41), MUTILS_BOOL2STR(cpuFeatures.features & MUtils::CPUFetaures::FLAG_SSE42), MUTILS_BOOL2STR(cpuFeatures.features & MUtils::CPUFetaures::FLAG_AVX), MUTILS_BOOL2STR(cpuFeatures.features & MUtils::CPUFetaures::FLAG_AVX2), MUTILS_BOOL2STR(cpuFeatures.features & MUtils::CPUFetaures::FLAG_FMA3), MUTILS_BOOL2STR(cpuFeatures.features & MUtils::CPUFetaures::FLAG_LZCNT));
 	qDebug(" Number of CPU's  :  %d\n", cpuFeatures.count);
 
+	//Benchmark the line parser against the QRegExp chain it replaced (debug builds only)
+#if defined(_DEBUG)
+	if(arguments.contains(CLI_PARAM_BENCH_PARSER))
+	{
+		LineParser::benchmark(10000);
+		qDebug(" ");
+	}
+#endif
+
 	//Initialize Qt
 	QScopedPointer<QApplication> application(MUtils::Startup::create_qt(argc, argv, QLatin1String("Simple x264 Launcher"), QLatin1String("LoRd_MuldeR"), QLatin1String("muldersoft.com"), false));
 	if(application.isNull())
@@ -21,12 +21,20 @@
 
 #include "mediainfo.h"
 
+//Internal
+#include "model_clipInfo.h"
+
+//Qt
 #include <QString>
 #include <QFile>
 #include <QByteArray>
 #include <QFileInfo>
 
 static const char *YUV4MPEG2 = "YUV4MPEG2";
+static const char *Y4M_FRAME = "FRAME";
+
+static const qint64 Y4M_MAX_HEADER_SIZE = 4096I64;
+static const qint64 Y4M_MAP_WINDOW_SIZE = 67108864I64;
 
 int MediaInfo::analyze(const QString &fileName)
 {
@@ -78,3 +86,219 @@ bool MediaInfo::isYuv4Mpeg(const QString &fileName)
 	//Compare YUV4MPEG2 signature
 	return (memcmp(header.constData(), YUV4MPEG2, len) == 0);
 }
+
+bool MediaInfo::parseYuv4MpegHeader(const char *const header, const size_t &len, yuv4mpeg_t &info)
+{
+	const size_t sigLen = strlen(YUV4MPEG2);
+	memset(&info, 0, sizeof(yuv4mpeg_t));
+
+	//Check YUV4MPEG2 signature
+	if((len < sigLen) || (memcmp(header, YUV4MPEG2, sigLen) != 0))
+	{
+		return false;
+	}
+
+	quint32 chromaFormat = 420, bitDepth = 8;
+
+	//Parse the parameter tokens
+	size_t pos = sigLen;
+	while(pos < len)
+	{
+		while((pos < len) && (header[pos] == ' ')) pos++;
+		if((pos >= len) || (header[pos] == '\n'))
+		{
+			break;
+		}
+		const char tag = header[pos++];
+		const char *const value = &header[pos];
+		size_t valueLen = 0;
+		while((pos < len) && (header[pos] != ' ') && (header[pos] != '\n'))
+		{
+			valueLen++; pos++;
+		}
+		switch(tag)
+		{
+		case 'W':
+			info.width = strtoul(value, NULL, 10);
+			break;
+		case 'H':
+			info.height = strtoul(value, NULL, 10);
+			break;
+		case 'F':
+			{
+				char *next = NULL;
+				info.fpsNum = strtoul(value, &next, 10);
+				info.fpsDen = (next && (*next == ':')) ? strtoul(next + 1, NULL, 10) : 1U;
+			}
+			break;
+		case 'C':
+			if((valueLen >= 4) && (memcmp(value, "mono", 4) == 0))
+			{
+				chromaFormat = 400;
+				bitDepth = (valueLen > 4) ? strtoul(value + 4, NULL, 10) : 8U;
+			}
+			else
+			{
+				char *next = NULL;
+				chromaFormat = strtoul(value, &next, 10);
+				if(next && (next[0] == 'p') && (next[1] >= '0') && (next[1] <= '9'))
+				{
+					bitDepth = strtoul(next + 1, NULL, 10);
+				}
+				else if(next && (valueLen >= 8) && (memcmp(value, "444alpha", 8) == 0))
+				{
+					chromaFormat = 4444;
+				}
+			}
+			break;
+		}
+	}
+
+	if((info.width < 1) || (info.height < 1) || (bitDepth < 8) || (bitDepth > 16))
+	{
+		return false;
+	}
+
+	//Compute the size of a single frame, in bytes
+	const quint64 lumaSize = quint64(info.width) * quint64(info.height);
+	quint64 chromaSize = 0;
+	switch(chromaFormat)
+	{
+	case 400:
+		chromaSize = 0;
+		break;
+	case 411:
+		chromaSize = 2 * quint64((info.width + 3) / 4) * quint64(info.height);
+		break;
+	case 420:
+		chromaSize = 2 * quint64((info.width + 1) / 2) * quint64((info.height + 1) / 2);
+		break;
+	case 422:
+		chromaSize = 2 * quint64((info.width + 1) / 2) * quint64(info.height);
+		break;
+	case 444:
+		chromaSize = 2 * lumaSize;
+		break;
+	case 4444:
+		chromaSize = 3 * lumaSize;
+		break;
+	default:
+		qWarning("[parseYuv4MpegHeader] Unsupported colorspace: %u", chromaFormat);
+		return false;
+	}
+
+	info.bitDepth = bitDepth;
+	info.frameSize = (lumaSize + chromaSize) * ((bitDepth > 8) ? 2U : 1U);
+	return true;
+}
+
+/*
+ * Get the clip properties of a YUV4MPEG2 file from its stream header, without running any tool. If the frames
+ * come with plain "FRAME" headers, the frame count follows from the file size. Otherwise (per-frame parameters)
+ * the frame headers have to be located one by one, which is done in a memory-mapped view of the file.
+ */
+bool MediaInfo::probeYuv4Mpeg(const QString &fileName, ClipInfo &clipInfo)
+{
+	QFile file(fileName);
+
+	//Try to open input file
+	if(!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("[probeYuv4Mpeg] Failed to open input file!");
+		return false;
+	}
+
+	//Read the stream header and the first frame header
+	const QByteArray buffer = file.read(2I64 * Y4M_MAX_HEADER_SIZE);
+	const qint64 headerLen = buffer.indexOf('\n') + 1;
+	yuv4mpeg_t info;
+	if((headerLen < 1) || (!parseYuv4MpegHeader(buffer.constData(), size_t(headerLen), info)))
+	{
+		qWarning("[probeYuv4Mpeg] Failed to parse the stream header!");
+		return false;
+	}
+
+	const qint64 fileSize = file.size();
+	const qint64 markerLen = strlen(Y4M_FRAME);
+	const quint64 plainFrameSize = info.frameSize + quint64(markerLen + 1);
+	quint64 frameCount = 0;
+
+	if(fileSize > headerLen)
+	{
+		const bool plainHeader = (buffer.size() > headerLen + markerLen) && (memcmp(buffer.constData() + headerLen, Y4M_FRAME, size_t(markerLen)) == 0) && (buffer.at(int(headerLen + markerLen)) == '\n');
+		if(plainHeader && ((quint64(fileSize - headerLen) % plainFrameSize) == 0))
+		{
+			frameCount = quint64(fileSize - headerLen) / plainFrameSize;
+		}
+		else
+		{
+			frameCount = countYuv4MpegFrames(file, headerLen, info.frameSize);
+		}
+	}
+
+	file.close();
+
+	clipInfo.setFrameSize(info.width, info.height);
+	clipInfo.setFrameRate(info.fpsNum, info.fpsDen);
+	clipInfo.setFrameCount(quint32(qMin(frameCount, quint64(0xFFFFFFFF))));
+	return true;
+}
+
+quint64 MediaInfo::countYuv4MpegFrames(QFile &file, const qint64 &offset, const quint64 &frameSize)
+{
+	const qint64 fileSize = file.size();
+	const qint64 markerLen = strlen(Y4M_FRAME);
+
+	qint64 pos = offset, viewStart = 0, viewSize = 0;
+	uchar *view = NULL;
+	quint64 frameCount = 0;
+
+	while(pos < fileSize)
+	{
+		//Move the view, unless the next frame header is contained in it already
+		if((!view) || ((pos + Y4M_MAX_HEADER_SIZE > viewStart + viewSize) && (viewStart + viewSize < fileSize)))
+		{
+			if(view)
+			{
+				file.unmap(view);
+			}
+			viewStart = pos;
+			viewSize = qMin(Y4M_MAP_WINDOW_SIZE, fileSize - pos);
+			if(!(view = file.map(viewStart, viewSize)))
+			{
+				qWarning("[countYuv4MpegFrames] Failed to map the input file!");
+				return 0;
+			}
+		}
+
+		const char *const header = reinterpret_cast<const char*>(view + (pos - viewStart));
+		const qint64 available = qMin(viewStart + viewSize - pos, Y4M_MAX_HEADER_SIZE);
+		if((available < markerLen) || (memcmp(header, Y4M_FRAME, size_t(markerLen)) != 0))
+		{
+			qWarning("[countYuv4MpegFrames] Frame header is missing, stream is corrupted!");
+			break;
+		}
+
+		const char *const eol = static_cast<const char*>(memchr(header, '\n', size_t(available)));
+		if(!eol)
+		{
+			qWarning("[countYuv4MpegFrames] Frame header is incomplete, stream is corrupted!");
+			break;
+		}
+
+		//Skip the frame payload, but don't count a truncated frame
+		pos += qint64(eol - header) + 1I64 + qint64(frameSize);
+		if(pos > fileSize)
+		{
+			break;
+		}
+		frameCount++;
+	}
+
+	if(view)
+	{
+		file.unmap(view);
+	}
+
+	return frameCount;
+}
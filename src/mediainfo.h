@@ -19,7 +19,11 @@
 // http://www.gnu.org/licenses/gpl-2.0.txt
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <qglobal.h>
+
 class QString;
+class QFile;
+class ClipInfo;
 
 class MediaInfo
 {
@@ -33,11 +37,25 @@ public:
 	}
 	fileType_t;
 
+	typedef struct
+	{
+		quint32 width;
+		quint32 height;
+		quint32 fpsNum;
+		quint32 fpsDen;
+		quint32 bitDepth;
+		quint64 frameSize;
+	}
+	yuv4mpeg_t;
+
 	static int analyze(const QString &fileName);
+	static bool parseYuv4MpegHeader(const char *const header, const size_t &len, yuv4mpeg_t &info);
+	static bool probeYuv4Mpeg(const QString &fileName, ClipInfo &clipInfo);
 
 private:
 	MediaInfo(void)  {/*NOP*/}
 	~MediaInfo(void) {/*NOP*/}
 
 	static bool isYuv4Mpeg(const QString &fileName);
+	static quint64 countYuv4MpegFrames(QFile &file, const qint64 &offset, const quint64 &frameSize);
 };
@@ -0,0 +1,212 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "memory_model.h"
+
+//Internal
+#include "global.h"
+#include "model_options.h"
+#include "model_clipInfo.h"
+
+//Qt
+#include <QString>
+#include <QRegExp>
+#include <QPair>
+#include <QSettings>
+#include <QMutex>
+
+//Windows includes
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+/*
+ * The memory model predicts the peak memory usage of a job, so that a job is only started if it fits into the
+ * available memory. The prediction assumes that the memory is dominated by the frames that the encoder keeps
+ * in flight (look-ahead, reference frames and frame threads), each of which is stored several times (e.g.
+ * interpolated planes and analysis data). Since the actual figures vary widely between encoder builds, the
+ * raw prediction is scaled by a correction factor per encoder, which is learned from the peak memory usage
+ * that has been measured on completed jobs. Clips with unknown resolution are assumed to be 1080p.
+ */
+
+static const quint64 MiB = 1048576I64;
+static const double FACTOR_WEIGHT = 0.3;
+static const quint64 RESERVE_DIVISOR = 20I64;
+
+static const struct
+{
+	quint64 baseMemory;
+	unsigned int extraFrames;
+	double planeCopies;
+}
+ENCODER_MODEL[3] =
+{
+	{  48I64 * MiB, 24, 4.0 },	/*x264*/
+	{  96I64 * MiB, 32, 6.0 },	/*x265*/
+	{ 160I64 * MiB, 16, 2.0 },	/*NVEnc*/
+};
+
+static const char *const PRESET_NAMES[10] =
+{
+	"ultrafast", "superfast", "veryfast", "faster", "fast", "medium", "slow", "slower", "veryslow", "placebo"
+};
+
+static const unsigned int PRESET_LOOKAHEAD[2][10] =
+{
+	{ 0,  0, 10, 20, 30, 40, 50, 60, 60, 60 },	/*x264*/
+	{ 5, 10, 15, 15, 15, 20, 25, 40, 40, 60 },	/*x265*/
+};
+
+static QMutex g_memoryModelMutex;
+
+///////////////////////////////////////////////////////////////////////////////
+// Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+quint64 MemoryModel::estimate(const OptionsModel *const options, const ClipInfo &clipInfo)
+{
+	QMutexLocker lock(&g_memoryModelMutex);
+	return static_cast<quint64>(static_cast<double>(estimateRaw(options, clipInfo)) * getFactor(options->encType()));
+}
+
+void MemoryModel::calibrate(const OptionsModel *const options, const ClipInfo &clipInfo, const quint64 &peakMemory)
+{
+	QMutexLocker lock(&g_memoryModelMutex);
+
+	const quint64 predicted = estimateRaw(options, clipInfo);
+	if((predicted < 1) || (peakMemory < 1))
+	{
+		return;
+	}
+
+	double &factor = getFactor(options->encType());
+	factor = qBound(0.25, ((1.0 - FACTOR_WEIGHT) * factor) + (FACTOR_WEIGHT * (static_cast<double>(peakMemory) / static_cast<double>(predicted))), 8.0);
+	qDebug("Memory model: Peak usage %llu MiB, predicted %llu MiB, factor now %.2f", peakMemory / MiB, predicted / MiB, factor);
+
+	QSettings settings(getModelFile(), QSettings::IniFormat);
+	settings.setValue(QString("factor_%1").arg(QString::number(options->encType())), factor);
+	settings.sync();
+}
+
+/*
+ * Physical memory that is available right now, minus a small reserve for the system
+ */
+quint64 MemoryModel::getAvailableMemory(void)
+{
+	MEMORYSTATUSEX memoryStatus;
+	memset(&memoryStatus, 0, sizeof(MEMORYSTATUSEX));
+	memoryStatus.dwLength = sizeof(MEMORYSTATUSEX);
+	if(!GlobalMemoryStatusEx(&memoryStatus))
+	{
+		qWarning("[MemoryModel] Failed to get the memory status!");
+		return 0;
+	}
+
+	const quint64 reserve = static_cast<quint64>(memoryStatus.ullTotalPhys) / RESERVE_DIVISOR;
+	const quint64 available = static_cast<quint64>(memoryStatus.ullAvailPhys);
+	return (available > reserve) ? (available - reserve) : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+
+quint64 MemoryModel::estimateRaw(const OptionsModel *const options, const ClipInfo &clipInfo)
+{
+	const int encType = qBound(0, static_cast<int>(options->encType()), 2);
+
+	QPair<quint32, quint32> frameSize = clipInfo.getFrameSize();
+	if((frameSize.first < 1) || (frameSize.second < 1))
+	{
+		frameSize = qMakePair(1920U, 1080U);
+	}
+
+	//Size of a single 4:2:0 frame at the output bit depth
+	const double bytesPerSample = (getBitDepth(options) > 8) ? 2.0 : 1.0;
+	const double frameBytes = static_cast<double>(frameSize.first) * static_cast<double>(frameSize.second) * 1.5 * bytesPerSample;
+
+	const unsigned int frames = getLookahead(options) + ENCODER_MODEL[encType].extraFrames;
+	return ENCODER_MODEL[encType].baseMemory + static_cast<quint64>(frameBytes * static_cast<double>(frames) * ENCODER_MODEL[encType].planeCopies);
+}
+
+unsigned int MemoryModel::getLookahead(const OptionsModel *const options)
+{
+	//An explicit look-ahead in the custom parameters takes precedence
+	QRegExp rcLookahead("--rc-lookahead[\\s=]+(\\d+)");
+	if(rcLookahead.indexIn(options->customEncParams()) >= 0)
+	{
+		return qMin(rcLookahead.cap(1).toUInt(), 250U);
+	}
+
+	if(options->encType() == OptionsModel::EncType_NVEnc)
+	{
+		return 0;
+	}
+
+	const QString preset = options->preset().simplified().toLower();
+	for(int i = 0; i < 10; i++)
+	{
+		if(preset.compare(QLatin1String(PRESET_NAMES[i])) == 0)
+		{
+			return PRESET_LOOKAHEAD[(options->encType() == OptionsModel::EncType_X265) ? 1 : 0][i];
+		}
+	}
+
+	return PRESET_LOOKAHEAD[(options->encType() == OptionsModel::EncType_X265) ? 1 : 0][5];
+}
+
+unsigned int MemoryModel::getBitDepth(const OptionsModel *const options)
+{
+	switch(options->encType())
+	{
+	case OptionsModel::EncType_X264:
+		return (options->encVariant() > 0) ? 10 : 8;
+	case OptionsModel::EncType_X265:
+		return (options->encVariant() > 1) ? 12 : ((options->encVariant() > 0) ? 10 : 8);
+	default:
+		return 8;
+	}
+}
+
+double &MemoryModel::getFactor(const int &encType)
+{
+	static bool loaded = false;
+	static double factors[3] = { 1.0, 1.0, 1.0 };
+
+	if(!loaded)
+	{
+		QSettings settings(getModelFile(), QSettings::IniFormat);
+		for(int i = 0; i < 3; i++)
+		{
+			factors[i] = qBound(0.25, settings.value(QString("factor_%1").arg(QString::number(i)), 1.0).toDouble(), 8.0);
+		}
+		loaded = true;
+	}
+
+	return factors[qBound(0, encType, 2)];
+}
+
+QString MemoryModel::getModelFile(void)
+{
+	return QString("%1/memory_model.ini").arg(x264_data_path());
+}
@@ -23,6 +23,8 @@
 #include "global.h"
 #include "model_jobList.h"
 #include "thread_encode.h"
+#include "thread_preindex.h"
+#include "thread_probe.h"
 #include "encoder_factory.h"
 #include "model_options.h"
 #include "model_preferences.h"
@@ -35,31 +37,72 @@
 #include <QIcon>
 #include <QFileInfo>
 #include <QSettings>
+#include <QTimer>
+#include <QtAlgorithms>
 
 static const char *KEY_ENTRY_COUNT = "entry_count";
 static const char *KEY_SOURCE_FILE = "source_file";
 static const char *KEY_OUTPUT_FILE = "output_file";
 static const char *KEY_ENC_OPTIONS = "enc_options";
+static const char *KEY_PRIORITY    = "priority";
+static const char *KEY_SUBMITTER   = "submitter";
 
 static const char *JOB_TEMPLATE = "job_%08x";
 
 #define VALID_INDEX(INDEX) ((INDEX).isValid() && ((INDEX).row() >= 0) && ((INDEX).row() < m_jobs.count()))
 
+static inline bool isActive(const JobStatus &status)
+{
+	return (status != JobStatus_Enqueued) && (status != JobStatus_Completed) && (status != JobStatus_Failed) && (status != JobStatus_Aborted);
+}
+
+typedef struct
+{
+	int priority;
+	double virtualTime;
+	quint64 sequence;
+	QModelIndex index;
+}
+candidate_t;
+
+static bool lessThanCandidate(const candidate_t &a, const candidate_t &b)
+{
+	if(a.priority != b.priority) return a.priority > b.priority;
+	if(a.virtualTime != b.virtualTime) return a.virtualTime < b.virtualTime;
+	return a.sequence < b.sequence;
+}
+
 JobListModel::JobListModel(PreferencesModel *preferences)
 {
 	m_preferences = preferences;
+	m_jobRowsDirty = false;
+	m_firstEnqueued = 0;
+	m_schedulerValid = false;
+	memset(m_statusCount, 0, sizeof(m_statusCount));
+
+	m_refreshTimer = new QTimer(this);
+	connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refreshJobs()));
+
+	m_preIndexer = new PreIndexThread(m_preferences);
+	m_preIndexer->start(QThread::LowestPriority);
+
+	//The memory admission relies on the clip properties, so probe the pending jobs with at least one thread
+	m_probeQueue = new ProbeQueue(m_preferences->getEnableMemoryAdmission() ? qMax(1U, m_preferences->getProbeThreads()) : m_preferences->getProbeThreads());
+	connect(m_probeQueue, SIGNAL(probeFinished(QUuid, bool)), this, SLOT(probeFinished(QUuid, bool)), Qt::QueuedConnection);
 }
 
 JobListModel::~JobListModel(void)
 {
-	while(!m_jobs.isEmpty())
+	MUTILS_DELETE(m_probeQueue);
+	m_preIndexer->shutdown();
+	MUTILS_DELETE(m_preIndexer);
+
+	for(QVector<job_t>::Iterator iter = m_jobs.begin(); iter != m_jobs.end(); iter++)
 	{
-		QUuid id = m_jobs.takeFirst();
-		EncodeThread *thread = m_threads.value(id, NULL);
-		LogFileModel *logFile = m_logFile.value(id, NULL);
-		MUTILS_DELETE(thread);
-		MUTILS_DELETE(logFile);
+		MUTILS_DELETE(iter->thread);
+		MUTILS_DELETE(iter->logFile);
 	}
+	m_jobs.clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -122,10 +165,10 @@ QVariant JobListModel::data(const QModelIndex &index, int role) const
 			switch(index.column())
 			{
 			case 0:
-				return m_name.value(m_jobs.at(index.row()));
+				return m_jobs.at(index.row()).name;
 				break;
 			case 1:
-				switch(m_status.value(m_jobs.at(index.row())))
+				switch(m_jobs.at(index.row()).status)
 				{
 				case JobStatus_Enqueued:
 					return QVariant::fromValue<QString>(tr("Enqueued."));
@@ -172,10 +215,10 @@ QVariant JobListModel::data(const QModelIndex &index, int role) const
 				}
 				break;
 			case 2:
-				return QString().sprintf("%d%%", m_progress.value(m_jobs.at(index.row())));
+				return QString().sprintf("%d%%", m_jobs.at(index.row()).progress);
 				break;
 			case 3:
-				return m_details.value(m_jobs.at(index.row()));
+				return m_jobs.at(index.row()).details;
 				break;
 			default:
 				return QVariant();
@@ -187,7 +230,7 @@ QVariant JobListModel::data(const QModelIndex &index, int role) const
 	{
 		if(index.row() >= 0 && index.row() < m_jobs.count() && index.column() == 0)
 		{
-			switch(m_status.value(m_jobs.at(index.row())))
+			switch(m_jobs.at(index.row()).status)
 			{
 			case JobStatus_Enqueued:
 				return QIcon(":/buttons/hourglass.png");
@@ -238,10 +281,10 @@ QVariant JobListModel::data(const QModelIndex &index, int role) const
 // Public interface
 ///////////////////////////////////////////////////////////////////////////////
 
-QModelIndex JobListModel::insertJob(EncodeThread *thread)
+QModelIndex JobListModel::insertJob(EncodeThread *thread, const int &priority, const QString &submitter)
 {
 	const QUuid id = thread->getId();
-	if(m_jobs.contains(id))
+	if(findJob(id) >= 0)
 	{
 		return QModelIndex();
 	}
@@ -262,55 +305,84 @@ QModelIndex JobListModel::insertJob(EncodeThread *thread)
 
 	int n = 2;
 	QString jobName = QString("%1 [%2]").arg(QFileInfo(thread->sourceFileName()).completeBaseName().simplified(), config);
-	forever
+	while(m_jobNames.contains(jobName.toCaseFolded()))
 	{
-		bool unique = true;
-		for(int i = 0; i < m_jobs.count(); i++)
-		{
-			if(m_name.value(m_jobs.at(i)).compare(jobName, Qt::CaseInsensitive) == 0)
-			{
-				unique = false;
-				break;
-			}
-		}
-		if(!unique)
-		{
-			jobName = QString("%1 %2 [%3]").arg(QFileInfo(thread->sourceFileName()).completeBaseName().simplified(), QString::number(n++), config);
-			continue;
-		}
-		break;
+		jobName = QString("%1 %2 [%3]").arg(QFileInfo(thread->sourceFileName()).completeBaseName().simplified(), QString::number(n++), config);
 	}
 	
 	LogFileModel *logFile = new LogFileModel(thread->sourceFileName(), thread->outputFileName(), config);
 	
+	job_t job;
+	job.id = id;
+	job.name = jobName;
+	job.thread = thread;
+	job.logFile = logFile;
+	job.status = job.workerStatus = JobStatus_Enqueued;
+	job.progress = 0;
+	job.details = tr("Not started yet.");
+	job.fps = 0.0;
+	job.eta = 0;
+	job.priority = priority;
+	job.submitter = submitter;
+	if(m_schedulerValid && (!m_preferences->getEnableFairShare()))
+	{
+		invalidateScheduler();
+	}
+	job.scheduled = m_schedulerValid;
+	job.sequence = job.scheduled ? m_scheduler.enqueue(id, submitter, priority) : 0;
+
 	beginInsertRows(QModelIndex(), m_jobs.count(), m_jobs.count());
-	m_jobs.append(id);
-	m_name.insert(id, jobName);
-	m_status.insert(id, JobStatus_Enqueued);
-	m_progress.insert(id, 0);
-	m_threads.insert(id, thread);
-	m_logFile.insert(id, logFile);
-	m_details.insert(id, tr("Not started yet."));
+	m_jobs.append(job);
+	if(!m_jobRowsDirty)
+	{
+		m_jobRows.insert(id, m_jobs.count() - 1);
+	}
+	m_jobNames.insert(jobName.toCaseFolded(), id);
+	countStatus(JobStatus_Enqueued, 1);
 	endInsertRows();
 
-	connect(thread, SIGNAL(statusChanged(QUuid, JobStatus)), this, SLOT(updateStatus(QUuid, JobStatus)), Qt::QueuedConnection);
-	connect(thread, SIGNAL(progressChanged(QUuid, unsigned int)), this, SLOT(updateProgress(QUuid, unsigned int)), Qt::QueuedConnection);
 	connect(thread, SIGNAL(messageLogged(QUuid, qint64, QString)), logFile, SLOT(addLogMessage(QUuid, qint64,  QString)), Qt::QueuedConnection);
-	connect(thread, SIGNAL(detailsChanged(QUuid, QString)), this, SLOT(updateDetails(QUuid, QString)), Qt::QueuedConnection);
+
+	//Probe the job ahead of time, while it is waiting in the queue
+	m_probeQueue->enqueue(thread);
+
+	//Index the source in the background, while the job is waiting in the queue
+	if(m_preferences->getEnablePreIndexing())
+	{
+		QString program, indexFile;
+		QStringList args;
+		if(thread->getIndexCommand(program, args, indexFile))
+		{
+			m_preIndexer->enqueue(id, program, args, indexFile);
+		}
+	}
 	
 	return createIndex(m_jobs.count() - 1, 0, NULL);
 }
 
-bool JobListModel::startJob(const QModelIndex &index)
+bool JobListModel::startJob(const QModelIndex &index, const unsigned int &jobLimit, const QList<QModelIndex> &sharedJobs)
 {
 	if(VALID_INDEX(index))
 	{
-		QUuid id = m_jobs.at(index.row());
-		if(m_status.value(id) == JobStatus_Enqueued)
+		const QUuid id = m_jobs.at(index.row()).id;
+		if(m_jobs.at(index.row()).status == JobStatus_Enqueued)
 		{
+			EncodeThread *const thread = m_jobs.at(index.row()).thread;
+			if(m_schedulerValid)
+			{
+				m_scheduler.charge(m_jobs.at(index.row()).submitter);
+			}
+			m_probeQueue->remove(thread);
 			updateStatus(id, JobStatus_Starting);
 			updateDetails(id, tr("Starting up, please wait..."));
-			m_threads.value(id)->start();
+			attachSharedJobs(thread, sharedJobs);
+			thread->setThreadBudget(getThreadBudget(jobLimit));
+			thread->setPreIndexer(m_preIndexer);
+			thread->start();
+			if(!m_refreshTimer->isActive())
+			{
+				m_refreshTimer->start(m_preferences->getRefreshInterval());
+			}
 			return true;
 		}
 	}
@@ -318,17 +390,108 @@ bool JobListModel::startJob(const QModelIndex &index)
 	return false;
 }
 
+/*
+ * Pending jobs that could share the source of the given job, in the order in which they would be started
+ */
+QList<QModelIndex> JobListModel::getSharedJobs(const QModelIndex &index)
+{
+	QList<QModelIndex> sharedJobs;
+	if((!VALID_INDEX(index)) || (!m_jobs.at(index.row()).thread))
+	{
+		return sharedJobs;
+	}
+
+	const EncodeThread *const thread = m_jobs.at(index.row()).thread;
+	QList<candidate_t> candidates;
+	for(QModelIndex other = nextEnqueuedJob(QModelIndex()); other.isValid(); other = nextEnqueuedJob(other))
+	{
+		const job_t &job = m_jobs.at(other.row());
+		if((other.row() != index.row()) && job.thread && thread->canShareSource(job.thread))
+		{
+			const candidate_t candidate = { job.priority, m_schedulerValid ? m_scheduler.getVirtualTime(job.submitter) : 0.0, m_schedulerValid ? job.sequence : quint64(other.row()), other };
+			candidates << candidate;
+		}
+	}
+
+	//With fair share scheduling, follow the order of the scheduler, otherwise the order of the list
+	if(m_schedulerValid)
+	{
+		qStableSort(candidates.begin(), candidates.end(), lessThanCandidate);
+	}
+
+	for(QList<candidate_t>::ConstIterator iter = candidates.constBegin(); iter != candidates.constEnd(); iter++)
+	{
+		sharedJobs << iter->index;
+	}
+
+	return sharedJobs;
+}
+
+/*
+ * Attach pending jobs that encode the same source to the job that is about to start, so that the source
+ * is decoded only once for all of them. The attached jobs are driven by the thread of the starting job.
+ * The caller decides which jobs may be attached, so that they fit into the slots and into the memory.
+ */
+void JobListModel::attachSharedJobs(EncodeThread *const thread, const QList<QModelIndex> &sharedJobs)
+{
+	unsigned int maxJobs = m_preferences->getSharedSourceJobs();
+
+	for(QList<QModelIndex>::ConstIterator iter = sharedJobs.constBegin(); (iter != sharedJobs.constEnd()) && (maxJobs > 0); iter++)
+	{
+		const int row = iter->row();
+		if(VALID_INDEX(*iter) && (m_jobs.at(row).status == JobStatus_Enqueued))
+		{
+			EncodeThread *const other = m_jobs.at(row).thread;
+			if(other && thread->addSharedOutput(other))
+			{
+				const QUuid id = m_jobs.at(row).id;
+				if(m_schedulerValid)
+				{
+					m_scheduler.charge(m_jobs.at(row).submitter);
+				}
+				m_probeQueue->remove(other);
+				updateStatus(id, JobStatus_Starting);
+				updateDetails(id, tr("Waiting for the shared source..."));
+				maxJobs--;
+			}
+		}
+	}
+}
+
+/*
+ * Share the logical processors among the jobs that are going to run at the same time, so that the encoders
+ * don't oversubscribe the CPU. A job that runs on its own keeps the default thread count of the encoder.
+ */
+unsigned int JobListModel::getThreadBudget(const unsigned int &jobLimit)
+{
+	const unsigned int running = countRunningJobs(), enqueued = countJobs(JobStatus_Enqueued);
+	const unsigned int fullSlots = running - countJobs(JobStatus_Running_Pass1);
+
+	//Jobs that are still enqueued will be started right away, as long as there are free slots. The limit is the
+	//effective one (as decided by the governor), and jobs in their first pass may exceed it, since they occupy
+	//only a fraction of a slot; they get a full slot, and thus the budget of a full slot, for the second pass.
+	const unsigned int concurrency = qMax(fullSlots, qMin(jobLimit, running + enqueued));
+	if(concurrency < 2U)
+	{
+		return 0U;
+	}
+
+	const unsigned int processors = static_cast<unsigned int>(qMax(1, QThread::idealThreadCount()));
+	return qMax(1U, processors / concurrency);
+}
+
 bool JobListModel::pauseJob(const QModelIndex &index)
 {
 	if(VALID_INDEX(index))
 	{
-		QUuid id = m_jobs.at(index.row());
-		JobStatus status = m_status.value(id);
-		if((status == JobStatus_Indexing) || (status == JobStatus_Running) ||
-			(status == JobStatus_Running_Pass1) || (status == JobStatus_Running_Pass2))
+		const job_t &job = m_jobs.at(index.row());
+		if((job.status == JobStatus_Indexing) || (job.status == JobStatus_Running) ||
+			(job.status == JobStatus_Running_Pass1) || (job.status == JobStatus_Running_Pass2))
 		{
+			const QUuid id = job.id;
+			EncodeThread *const thread = job.thread;
 			updateStatus(id, JobStatus_Pausing);
-			m_threads.value(id)->pauseJob();
+			thread->pauseJob();
 			return true;
 		}
 	}
@@ -340,12 +503,13 @@ bool JobListModel::resumeJob(const QModelIndex &index)
 {
 	if(VALID_INDEX(index))
 	{
-		QUuid id = m_jobs.at(index.row());
-		JobStatus status = m_status.value(id);
-		if(status == JobStatus_Paused)
+		const job_t &job = m_jobs.at(index.row());
+		if(job.status == JobStatus_Paused)
 		{
+			const QUuid id = job.id;
+			EncodeThread *const thread = job.thread;
 			updateStatus(id, JobStatus_Resuming);
-			m_threads.value(id)->resumeJob();
+			thread->resumeJob();
 			return true;
 		}
 	}
@@ -357,12 +521,14 @@ bool JobListModel::abortJob(const QModelIndex &index)
 {
 	if(VALID_INDEX(index))
 	{
-		QUuid id = m_jobs.at(index.row());
-		if(m_status.value(id) == JobStatus_Indexing || m_status.value(id) == JobStatus_Running ||
-			m_status.value(id) == JobStatus_Running_Pass1 || JobStatus_Running_Pass2)
+		const job_t &job = m_jobs.at(index.row());
+		if(job.status == JobStatus_Indexing || job.status == JobStatus_Running ||
+			job.status == JobStatus_Running_Pass1 || JobStatus_Running_Pass2)
 		{
+			const QUuid id = job.id;
+			EncodeThread *const thread = job.thread;
 			updateStatus(id, JobStatus_Aborting);
-			m_threads.value(id)->abortJob();
+			thread->abortJob();
 			return true;
 		}
 	}
@@ -374,25 +540,32 @@ bool JobListModel::deleteJob(const QModelIndex &index)
 {
 	if(VALID_INDEX(index))
 	{
-		QUuid id = m_jobs.at(index.row());
-		if(m_status.value(id) == JobStatus_Completed || m_status.value(id) == JobStatus_Failed ||
-			m_status.value(id) == JobStatus_Aborted || m_status.value(id) == JobStatus_Enqueued)
+		const job_t &job = m_jobs.at(index.row());
+		if(job.status == JobStatus_Completed || job.status == JobStatus_Failed ||
+			job.status == JobStatus_Aborted || job.status == JobStatus_Enqueued)
 		{
 			int idx = index.row();
-			QUuid id = m_jobs.at(idx);
-			EncodeThread *thread = m_threads.value(id, NULL);
-			LogFileModel *logFile = m_logFile.value(id, NULL);
+			const QUuid id = job.id;
+			EncodeThread *thread = job.thread;
+			LogFileModel *logFile = job.logFile;
 			if((thread == NULL) || (!thread->isRunning()))
 			{
-				
+				if(job.scheduled)
+				{
+					m_scheduler.remove(id, job.submitter);
+				}
+				m_preIndexer->cancel(id);
+				if(thread)
+				{
+					m_probeQueue->cancel(thread);
+				}
 				beginRemoveRows(QModelIndex(), idx, idx);
-				m_jobs.removeAt(index.row());
-				m_name.remove(id);
-				m_threads.remove(id);
-				m_status.remove(id);
-				m_progress.remove(id);
-				m_logFile.remove(id);
-				m_details.remove(id);
+				countStatus(job.status, -1);
+				m_jobNames.remove(job.name.toCaseFolded());
+				m_jobRows.remove(id);
+				m_jobs.remove(idx);
+				m_jobRowsDirty = m_jobRowsDirty || (idx < m_jobs.count());
+				m_firstEnqueued = qMin(m_firstEnqueued, idx);
 				endRemoveRows();
 				MUTILS_DELETE(thread);
 				MUTILS_DELETE(logFile);
@@ -408,17 +581,30 @@ bool JobListModel::moveJob(const QModelIndex &index, const int &direction)
 {
 	if(VALID_INDEX(index))
 	{
-		if((direction == MOVE_UP) && (index.row() > 0))
+		const int row = index.row();
+		if((direction == MOVE_UP) && (row > 0))
 		{
-			beginMoveRows(QModelIndex(), index.row(), index.row(), QModelIndex(), index.row() - 1);
-			m_jobs.swap(index.row(), index.row() - 1);
+			beginMoveRows(QModelIndex(), row, row, QModelIndex(), row - 1);
+			qSwap(m_jobs[row], m_jobs[row - 1]);
+			m_firstEnqueued = qMin(m_firstEnqueued, row - 1);
+			if(!m_jobRowsDirty)
+			{
+				m_jobRows.insert(m_jobs.at(row).id, row);
+				m_jobRows.insert(m_jobs.at(row - 1).id, row - 1);
+			}
 			endMoveRows();
 			return true;
 		}
-		if((direction == MOVE_DOWN) && (index.row() < m_jobs.size() - 1))
+		if((direction == MOVE_DOWN) && (row < m_jobs.size() - 1))
 		{
-			beginMoveRows(QModelIndex(), index.row(), index.row(), QModelIndex(), index.row() + 2);
-			m_jobs.swap(index.row(), index.row() + 1);
+			beginMoveRows(QModelIndex(), row, row, QModelIndex(), row + 2);
+			qSwap(m_jobs[row], m_jobs[row + 1]);
+			m_firstEnqueued = qMin(m_firstEnqueued, row);
+			if(!m_jobRowsDirty)
+			{
+				m_jobRows.insert(m_jobs.at(row).id, row);
+				m_jobRows.insert(m_jobs.at(row + 1).id, row + 1);
+			}
 			endMoveRows();
 			return true;
 		}
@@ -427,11 +613,64 @@ bool JobListModel::moveJob(const QModelIndex &index, const int &direction)
 	return false;
 }
 
+/*
+ * Take the enqueued job that the scheduler wants to start next. The job is no longer scheduled afterwards,
+ * so it has to be handed back via requeueJob(), if it is not started after all. The scheduler is only kept
+ * up to date while fair share scheduling is enabled, so it is (re-)built from the list on first use.
+ */
+QModelIndex JobListModel::takeNextJob(void)
+{
+	if(!m_schedulerValid)
+	{
+		m_scheduler.clear();
+		for(QVector<job_t>::Iterator iter = m_jobs.begin(); iter != m_jobs.end(); iter++)
+		{
+			iter->scheduled = (iter->status == JobStatus_Enqueued);
+			iter->sequence = iter->scheduled ? m_scheduler.enqueue(iter->id, iter->submitter, iter->priority) : 0;
+		}
+		m_schedulerValid = true;
+	}
+
+	QUuid jobId;
+	while(m_scheduler.takeNext(jobId))
+	{
+		const int row = findJob(jobId);
+		if(row >= 0)
+		{
+			m_jobs[row].scheduled = false;
+			if(m_jobs.at(row).status == JobStatus_Enqueued)
+			{
+				return createIndex(row, 0, NULL);
+			}
+		}
+	}
+
+	return QModelIndex();
+}
+
+void JobListModel::requeueJob(const QModelIndex &index)
+{
+	if(VALID_INDEX(index) && m_schedulerValid)
+	{
+		job_t &job = m_jobs[index.row()];
+		if((job.status == JobStatus_Enqueued) && (!job.scheduled))
+		{
+			m_scheduler.requeue(job.id, job.submitter, job.priority, job.sequence);
+			job.scheduled = true;
+		}
+	}
+}
+
+void JobListModel::setSubmitterWeight(const QString &submitter, const double &weight)
+{
+	m_scheduler.setWeight(submitter, weight);
+}
+
 LogFileModel *JobListModel::getLogFile(const QModelIndex &index)
 {
 	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
 	{
-		return m_logFile.value(m_jobs.at(index.row()));
+		return m_jobs.at(index.row()).logFile;
 	}
 
 	return NULL;
@@ -443,7 +682,7 @@ const QString &JobListModel::getJobSourceFile(const QModelIndex &index)
 	
 	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
 	{
-		EncodeThread *thread = m_threads.value(m_jobs.at(index.row()));
+		EncodeThread *thread = m_jobs.at(index.row()).thread;
 		return (thread != NULL) ? thread->sourceFileName() : nullStr;
 	}
 
@@ -456,7 +695,7 @@ const QString &JobListModel::getJobOutputFile(const QModelIndex &index)
 	
 	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
 	{
-		EncodeThread *thread = m_threads.value(m_jobs.at(index.row()));
+		EncodeThread *thread = m_jobs.at(index.row()).thread;
 		return (thread != NULL) ? thread->outputFileName() : nullStr;
 	}
 
@@ -467,7 +706,7 @@ JobStatus JobListModel::getJobStatus(const QModelIndex &index)
 {
 	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
 	{
-		return m_status.value(m_jobs.at(index.row()));
+		return m_jobs.at(index.row()).status;
 	}
 
 	return static_cast<JobStatus>(-1);
@@ -477,7 +716,27 @@ unsigned int JobListModel::getJobProgress(const QModelIndex &index)
 {
 	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
 	{
-		return m_progress.value(m_jobs.at(index.row()));
+		return m_jobs.at(index.row()).progress;
+	}
+
+	return 0;
+}
+
+double JobListModel::getJobFps(const QModelIndex &index)
+{
+	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
+	{
+		return m_jobs.at(index.row()).fps;
+	}
+
+	return 0.0;
+}
+
+unsigned int JobListModel::getJobEta(const QModelIndex &index)
+{
+	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
+	{
+		return m_jobs.at(index.row()).eta;
 	}
 
 	return 0;
@@ -489,23 +748,100 @@ const OptionsModel *JobListModel::getJobOptions(const QModelIndex &index)
 	
 	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
 	{
-		EncodeThread *thread = m_threads.value(m_jobs.at(index.row()));
+		EncodeThread *thread = m_jobs.at(index.row()).thread;
 		return (thread != NULL) ? thread->options() : NULL;
 	}
 
 	return NULL;
 }
 
+bool JobListModel::getJobClipInfo(const QModelIndex &index, ClipInfo &clipInfo)
+{
+	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
+	{
+		return m_jobs.at(index.row()).thread->estimateClipInfo(clipInfo);
+	}
+
+	return false;
+}
+
 QModelIndex JobListModel::getJobIndexById(const QUuid &id)
 {
-	if(m_jobs.contains(id))
+	const int row = findJob(id);
+	if(row >= 0)
 	{
-		return createIndex(m_jobs.indexOf(id), 0);
+		return createIndex(row, 0);
 	}
 
 	return QModelIndex();
 }
 
+QUuid JobListModel::getJobId(const QModelIndex &index)
+{
+	if(index.isValid() && index.row() >= 0 && index.row() < m_jobs.count())
+	{
+		return m_jobs.at(index.row()).id;
+	}
+
+	return QUuid();
+}
+
+/*
+ * Find the next enqueued job in list order, after the given row (or from the top, if the index is invalid).
+ * Jobs never return to the queue, so the rows above the first enqueued job are only scanned once, unless a
+ * job is moved or deleted there.
+ */
+QModelIndex JobListModel::nextEnqueuedJob(const QModelIndex &index)
+{
+	if(countJobs(JobStatus_Enqueued) < 1)
+	{
+		return QModelIndex();
+	}
+
+	int row = VALID_INDEX(index) ? (index.row() + 1) : 0;
+	const bool fromFirst = (row <= m_firstEnqueued);
+	for(row = qMax(row, m_firstEnqueued); row < m_jobs.count(); row++)
+	{
+		if(m_jobs.at(row).status == JobStatus_Enqueued)
+		{
+			break;
+		}
+	}
+
+	if(fromFirst)
+	{
+		m_firstEnqueued = row;
+	}
+
+	return (row < m_jobs.count()) ? createIndex(row, 0, NULL) : QModelIndex();
+}
+
+unsigned int JobListModel::countJobs(const JobStatus &status) const
+{
+	if((status >= JobStatus_Enqueued) && (status <= JobStatus_Aborted))
+	{
+		return m_statusCount[status];
+	}
+
+	return 0;
+}
+
+/*
+ * Jobs that are not completed (or failed, or aborted) yet
+ */
+unsigned int JobListModel::countPendingJobs(void) const
+{
+	return static_cast<unsigned int>(m_jobs.count()) - countJobs(JobStatus_Completed) - countJobs(JobStatus_Aborted) - countJobs(JobStatus_Failed);
+}
+
+/*
+ * Jobs that are still active, i.e. not terminated or enqueued
+ */
+unsigned int JobListModel::countRunningJobs(void) const
+{
+	return countPendingJobs() - countJobs(JobStatus_Enqueued);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Slots
 ///////////////////////////////////////////////////////////////////////////////
@@ -514,25 +850,13 @@ void JobListModel::updateStatus(const QUuid &jobId, JobStatus newStatus)
 {
 	int index = -1;
 	
-	if((index = m_jobs.indexOf(jobId)) >= 0)
+	if((index = findJob(jobId)) >= 0)
 	{
-		m_status.insert(jobId, newStatus);
+		const bool changed = setStatus(index, newStatus);
 		emit dataChanged(createIndex(index, 0), createIndex(index, 1));
-
-		if(m_preferences->getEnableSounds())
+		if(changed)
 		{
-			switch(newStatus)
-			{
-			case JobStatus_Completed:
-				MUtils::Sound::play_sound("tada", true);
-				break;
-			case JobStatus_Aborted:
-				MUtils::Sound::play_sound("shattering", true);
-				break;
-			case JobStatus_Failed:
-				MUtils::Sound::play_sound("failure", true);
-				break;
-			}
+			emit jobStatusChanged(createIndex(index, 0), newStatus);
 		}
 	}
 }
@@ -541,9 +865,9 @@ void JobListModel::updateProgress(const QUuid &jobId, unsigned int newProgress)
 {
 	int index = -1;
 
-	if((index = m_jobs.indexOf(jobId)) >= 0)
+	if((index = findJob(jobId)) >= 0)
 	{
-		m_progress.insert(jobId, qBound(0U, newProgress, 100U));
+		m_jobs[index].progress = qBound(0U, newProgress, 100U);
 		emit dataChanged(createIndex(index, 2), createIndex(index, 2));
 	}
 }
@@ -552,13 +876,207 @@ void JobListModel::updateDetails(const QUuid &jobId, const QString &details)
 {
 	int index = -1;
 
-	if((index = m_jobs.indexOf(jobId)) >= 0)
+	if((index = findJob(jobId)) >= 0)
 	{
-		m_details.insert(jobId, details);
+		m_jobs[index].details = details;
 		emit dataChanged(createIndex(index, 3), createIndex(index, 3));
 	}
 }
 
+/*
+ * Sample the state of all jobs whose worker has published a new snapshot since the last tick. All changes are
+ * reported with a single dataChanged() covering the affected rows, so the views repaint at most once per tick,
+ * regardless of how fast the encoders are printing progress.
+ */
+void JobListModel::refreshJobs(void)
+{
+	int firstRow = m_jobs.count(), lastRow = -1, activeJobs = 0;
+	QList<QPair<int, JobStatus> > statusChanges;
+	EncodeThread::snapshot_t snapshot;
+
+	//Jobs that are enqueued or terminated don't publish any snapshots, so only the active jobs are polled.
+	//Take a copy, because the list changes as soon as a job terminates.
+	QList<int> activeRows;
+	for(QList<QUuid>::ConstIterator iter = m_activeJobs.constBegin(); iter != m_activeJobs.constEnd(); iter++)
+	{
+		const int row = findJob(*iter);
+		if((row >= 0) && m_jobs.at(row).thread)
+		{
+			activeRows << row;
+		}
+	}
+
+	//Check first, so we can not miss the final snapshot of a job that is just about to finish (a job that shares
+	//the source of another job has its snapshots published by the other job's thread, which may be in any row)
+	for(QList<int>::ConstIterator iter = activeRows.constBegin(); iter != activeRows.constEnd(); iter++)
+	{
+		if(m_jobs.at(*iter).thread->isRunning())
+		{
+			activeJobs++;
+		}
+	}
+
+	for(QList<int>::ConstIterator iter = activeRows.constBegin(); iter != activeRows.constEnd(); iter++)
+	{
+		const int row = *iter;
+		job_t &job = m_jobs[row];
+		if(job.thread->takeSnapshot(snapshot))
+		{
+			if(snapshot.status != job.workerStatus)
+			{
+				//Only apply status changes originating from the worker, so the intermediate status that was
+				//set on the GUI side (e.g. "Pausing") is not overwritten by a snapshot that was already stale
+				job.workerStatus = snapshot.status;
+				if(setStatus(row, snapshot.status))
+				{
+					statusChanges << qMakePair(row, snapshot.status);
+				}
+			}
+			job.progress = qBound(0U, snapshot.progress, 100U);
+			if(!snapshot.details.isEmpty())
+			{
+				job.details = snapshot.details;
+			}
+			job.fps = snapshot.fps;
+			job.eta = snapshot.eta;
+			firstRow = qMin(firstRow, row);
+			lastRow = qMax(lastRow, row);
+		}
+	}
+
+	if(lastRow >= 0)
+	{
+		emit dataChanged(createIndex(firstRow, 0), createIndex(lastRow, 3));
+	}
+
+	for(QList<QPair<int, JobStatus> >::ConstIterator iter = statusChanges.constBegin(); iter != statusChanges.constEnd(); iter++)
+	{
+		emit jobStatusChanged(createIndex(iter->first, 0), iter->second);
+	}
+
+	if(activeJobs < 1)
+	{
+		m_refreshTimer->stop();
+	}
+}
+
+/*
+ * A pending job whose look-ahead probe has failed would fail as soon as it is started, so flag it right away
+ */
+void JobListModel::probeFinished(const QUuid &jobId, const bool &success)
+{
+	const int row = findJob(jobId);
+	if((!success) && (row >= 0) && (m_jobs.at(row).status == JobStatus_Enqueued))
+	{
+		updateStatus(jobId, JobStatus_Failed);
+		updateDetails(jobId, tr("The look-ahead probe has failed. See log for details!"));
+	}
+}
+
+bool JobListModel::setStatus(const int &row, const JobStatus &newStatus)
+{
+	job_t &job = m_jobs[row];
+	if(job.status == newStatus)
+	{
+		return false;
+	}
+
+	countStatus(job.status, -1);
+	countStatus(newStatus, 1);
+
+	//A job that leaves the queue by other means than the scheduler must not be scheduled any longer
+	if(job.scheduled && (newStatus != JobStatus_Enqueued))
+	{
+		m_scheduler.remove(job.id, job.submitter);
+		job.scheduled = false;
+	}
+
+	//A job that has been detached from a shared source returns to the queue, where it keeps its place
+	if(newStatus == JobStatus_Enqueued)
+	{
+		m_firstEnqueued = qMin(m_firstEnqueued, row);
+		if(m_schedulerValid && (!job.scheduled))
+		{
+			m_scheduler.requeue(job.id, job.submitter, job.priority, job.sequence);
+			job.scheduled = true;
+		}
+	}
+
+	//Keep track of the active jobs, in the order they were started
+	if(isActive(newStatus) != isActive(job.status))
+	{
+		if(isActive(newStatus))
+		{
+			m_activeJobs.append(job.id);
+		}
+		else
+		{
+			m_activeJobs.removeAll(job.id);
+		}
+	}
+
+	job.status = newStatus;
+
+	if(m_preferences->getEnableSounds())
+	{
+		switch(newStatus)
+		{
+		case JobStatus_Completed:
+			MUtils::Sound::play_sound("tada", true);
+			break;
+		case JobStatus_Aborted:
+			MUtils::Sound::play_sound("shattering", true);
+			break;
+		case JobStatus_Failed:
+			MUtils::Sound::play_sound("failure", true);
+			break;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Drop all jobs from the scheduler, e.g. after fair share scheduling has been disabled
+ */
+void JobListModel::invalidateScheduler(void)
+{
+	m_scheduler.clear();
+	for(QVector<job_t>::Iterator iter = m_jobs.begin(); iter != m_jobs.end(); iter++)
+	{
+		iter->scheduled = false;
+	}
+	m_schedulerValid = false;
+}
+
+/*
+ * Find the row of a job. Removing a row shifts all rows behind it, so the index is rebuilt lazily, on the
+ * next lookup, which keeps the removal of many jobs in a row at linear cost.
+ */
+int JobListModel::findJob(const QUuid &jobId)
+{
+	if(m_jobRowsDirty)
+	{
+		m_jobRows.clear();
+		m_jobRows.reserve(m_jobs.count());
+		for(int row = 0; row < m_jobs.count(); row++)
+		{
+			m_jobRows.insert(m_jobs.at(row).id, row);
+		}
+		m_jobRowsDirty = false;
+	}
+
+	return m_jobRows.value(jobId, -1);
+}
+
+void JobListModel::countStatus(const JobStatus &status, const int &delta)
+{
+	if((status >= JobStatus_Enqueued) && (status <= JobStatus_Aborted))
+	{
+		m_statusCount[status] += delta;
+	}
+}
+
 size_t JobListModel::saveQueuedJobs(void)
 {
 	const QString appDir = x264_data_path();
@@ -568,15 +1086,17 @@ size_t JobListModel::saveQueuedJobs(void)
 	settings.setValue(KEY_ENTRY_COUNT, 0);
 	size_t jobCounter = 0;
 
-	for(QList<QUuid>::ConstIterator iter = m_jobs.constBegin(); iter != m_jobs.constEnd(); iter++)
+	for(QVector<job_t>::ConstIterator iter = m_jobs.constBegin(); iter != m_jobs.constEnd(); iter++)
 	{
-		if(m_status.value(*iter) == JobStatus_Enqueued)
+		if(iter->status == JobStatus_Enqueued)
 		{
-			if(const EncodeThread *thread = m_threads.value(*iter))
+			if(const EncodeThread *thread = iter->thread)
 			{
 				settings.beginGroup(QString().sprintf(JOB_TEMPLATE, jobCounter++));
 				settings.setValue(KEY_SOURCE_FILE, thread->sourceFileName());
 				settings.setValue(KEY_OUTPUT_FILE, thread->outputFileName());
+				settings.setValue(KEY_PRIORITY, iter->priority);
+				settings.setValue(KEY_SUBMITTER, iter->submitter);
 
 				settings.beginGroup(KEY_ENC_OPTIONS);
 				OptionsModel::saveOptions(thread->options(), settings);
@@ -621,6 +1141,8 @@ size_t JobListModel::loadQueuedJobs(const SysinfoModel *sysinfo)
 		settings.beginGroup(QString().sprintf(JOB_TEMPLATE, i));
 		const QString sourceFileName = settings.value(KEY_SOURCE_FILE, QString()).toString().trimmed();
 		const QString outputFileName = settings.value(KEY_OUTPUT_FILE, QString()).toString().trimmed();
+		const int priority = settings.value(KEY_PRIORITY, 0).toInt();
+		const QString submitter = settings.value(KEY_SUBMITTER, QString()).toString();
 
 		if(sourceFileName.isEmpty() || outputFileName.isEmpty())
 		{
@@ -638,7 +1160,7 @@ size_t JobListModel::loadQueuedJobs(const SysinfoModel *sysinfo)
 		if(okay)
 		{
 			EncodeThread *thread = new EncodeThread(sourceFileName, outputFileName, &options, sysinfo, m_preferences);
-			insertJob(thread);
+			insertJob(thread, priority, submitter);
 			jobsCreated++;
 		}
 	}
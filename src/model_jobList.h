@@ -23,13 +23,18 @@
 
 #include "thread_encode.h"
 #include "model_logFile.h"
+#include "job_scheduler.h"
 
 #include "QAbstractItemModel"
 #include <QUuid>
 #include <QList>
-#include <QMap>
+#include <QVector>
+#include <QHash>
 
 class PreferencesModel;
+class PreIndexThread;
+class ProbeQueue;
+class QTimer;
 
 class JobListModel : public QAbstractItemModel
 {
@@ -46,20 +51,33 @@ public:
 	virtual QModelIndex parent (const QModelIndex &index) const;
 	virtual QVariant data(const QModelIndex &index, int role) const;
 
-	QModelIndex insertJob(EncodeThread *thread);
-	bool startJob(const QModelIndex &index);
+	QModelIndex insertJob(EncodeThread *thread, const int &priority = 0, const QString &submitter = QString());
+	bool startJob(const QModelIndex &index, const unsigned int &jobLimit, const QList<QModelIndex> &sharedJobs = QList<QModelIndex>());
+	QList<QModelIndex> getSharedJobs(const QModelIndex &index);
 	bool pauseJob(const QModelIndex &index);
 	bool resumeJob(const QModelIndex &index);
 	bool abortJob(const QModelIndex &index);
 	bool deleteJob(const QModelIndex &index);
 	bool moveJob(const QModelIndex &index, const int &direction);
+	QModelIndex takeNextJob(void);
+	void requeueJob(const QModelIndex &index);
+	void setSubmitterWeight(const QString &submitter, const double &weight);
 	LogFileModel *getLogFile(const QModelIndex &index);
 	const QString &getJobSourceFile(const QModelIndex &index);
 	const QString &getJobOutputFile(const QModelIndex &index);
 	JobStatus getJobStatus(const QModelIndex &index);
 	unsigned int getJobProgress(const QModelIndex &index);
+	double getJobFps(const QModelIndex &index);
+	unsigned int getJobEta(const QModelIndex &index);
 	const OptionsModel *getJobOptions(const QModelIndex &index);
+	bool getJobClipInfo(const QModelIndex &index, ClipInfo &clipInfo);
 	QModelIndex getJobIndexById(const QUuid &id);
+	QUuid getJobId(const QModelIndex &index);
+	QModelIndex nextEnqueuedJob(const QModelIndex &index);
+	const QList<QUuid> &getActiveJobs(void) const { return m_activeJobs; }
+	unsigned int countJobs(const JobStatus &status) const;
+	unsigned int countPendingJobs(void) const;
+	unsigned int countRunningJobs(void) const;
 
 	size_t saveQueuedJobs(void);
 	size_t loadQueuedJobs(const SysinfoModel *sysinfo);
@@ -73,17 +91,55 @@ public:
 	move_t;
 
 protected:
-	QList<QUuid> m_jobs;
-	QMap<QUuid, QString> m_name;
-	QMap<QUuid, EncodeThread*> m_threads;
-	QMap<QUuid, JobStatus> m_status;
-	QMap<QUuid, unsigned int> m_progress;
-	QMap<QUuid, LogFileModel*> m_logFile;
-	QMap<QUuid, QString> m_details;
+	typedef struct
+	{
+		QUuid id;
+		QString name;
+		EncodeThread *thread;
+		LogFileModel *logFile;
+		JobStatus status;
+		JobStatus workerStatus;
+		unsigned int progress;
+		QString details;
+		double fps;
+		unsigned int eta;
+		int priority;
+		QString submitter;
+		quint64 sequence;
+		bool scheduled;
+	}
+	job_t;
+
+	QVector<job_t> m_jobs;
+	QHash<QUuid, int> m_jobRows;
+	QHash<QString, QUuid> m_jobNames;
+	QList<QUuid> m_activeJobs;
+	unsigned int m_statusCount[JobStatus_Aborted + 1];
+	bool m_jobRowsDirty;
+	int m_firstEnqueued;
+	JobScheduler m_scheduler;
+	bool m_schedulerValid;
 	PreferencesModel *m_preferences;
+	QTimer *m_refreshTimer;
+	PreIndexThread *m_preIndexer;
+	ProbeQueue *m_probeQueue;
+
+	int findJob(const QUuid &jobId);
+	bool setStatus(const int &row, const JobStatus &newStatus);
+	void countStatus(const JobStatus &status, const int &delta);
+	void invalidateScheduler(void);
+	void attachSharedJobs(EncodeThread *const thread, const QList<QModelIndex> &sharedJobs);
+	unsigned int getThreadBudget(const unsigned int &jobLimit);
 
 public slots:
 	void updateStatus(const QUuid &jobId, JobStatus newStatus);
 	void updateProgress(const QUuid &jobId, unsigned int newProgress);
 	void updateDetails(const QUuid &jobId, const QString &details);
+
+private slots:
+	void refreshJobs(void);
+	void probeFinished(const QUuid &jobId, const bool &success);
+
+signals:
+	void jobStatusChanged(const QModelIndex &index, const JobStatus &newStatus);
 };
@@ -69,19 +69,34 @@ PreferencesModel::PreferencesModel(void)
 
 void PreferencesModel::initPreferences(PreferencesModel *preferences)
 {
-	INIT_VALUE(AutoRunNextJob,     true );
-	INIT_VALUE(MaxRunningJobCount, 1    );
-	INIT_VALUE(Prefer64BitSource,  false);
-	INIT_VALUE(SaveLogFiles,       false);
-	INIT_VALUE(SaveToSourcePath,   false);
-	INIT_VALUE(ProcessPriority,    -1   );
-	INIT_VALUE(EnableSounds,       false);
-	INIT_VALUE(DisableWarnings,    false);
-	INIT_VALUE(NoUpdateReminder,   false);
-	INIT_VALUE(AbortOnTimeout,     true );
-	INIT_VALUE(SkipVersionTest,    false);
-	INIT_VALUE(NoSystrayWarning,   false);
-	INIT_VALUE(SaveQueueNoConfirm, false);
+	INIT_VALUE(AutoRunNextJob,            true );
+	INIT_VALUE(MaxRunningJobCount,        1    );
+	INIT_VALUE(Prefer64BitSource,         false);
+	INIT_VALUE(SaveLogFiles,              false);
+	INIT_VALUE(SaveToSourcePath,          false);
+	INIT_VALUE(ProcessPriority,           -1   );
+	INIT_VALUE(EnableSounds,              false);
+	INIT_VALUE(DisableWarnings,           false);
+	INIT_VALUE(NoUpdateReminder,          false);
+	INIT_VALUE(AbortOnTimeout,            true );
+	INIT_VALUE(SkipVersionTest,           false);
+	INIT_VALUE(NoSystrayWarning,          false);
+	INIT_VALUE(SaveQueueNoConfirm,        false);
+	INIT_VALUE(EnableFramePump,           false);
+	INIT_VALUE(FrameBufferCount,          0    );
+	INIT_VALUE(FrameBufferLimit,          256  );
+	INIT_VALUE(RefreshInterval,           250  );
+	INIT_VALUE(ParallelChunks,            0    );
+	INIT_VALUE(SharedSourceJobs,          0    );
+	INIT_VALUE(FirstPassLoad,             100  );
+	INIT_VALUE(EnablePreIndexing,         false);
+	INIT_VALUE(IndexCacheQuota,           4096 );
+	INIT_VALUE(ProbeThreads,              0    );
+	INIT_VALUE(EnableStreamProbe,         false);
+	INIT_VALUE(EnableAffinityPlanner,     false);
+	INIT_VALUE(EnableConcurrencyGovernor, false);
+	INIT_VALUE(EnableMemoryAdmission,     false);
+	INIT_VALUE(EnableFairShare,           false);
 }
 
 void PreferencesModel::loadPreferences(PreferencesModel *preferences)
@@ -91,21 +106,44 @@ void PreferencesModel::loadPreferences(PreferencesModel *preferences)
 	QSettings settings(QString("%1/preferences.ini").arg(appDir), QSettings::IniFormat);
 	settings.beginGroup("preferences");
 
-	LOAD_VALUE_B(AutoRunNextJob    );
-	LOAD_VALUE_U(MaxRunningJobCount);
-	LOAD_VALUE_B(Prefer64BitSource );
-	LOAD_VALUE_B(SaveLogFiles      );
-	LOAD_VALUE_B(SaveToSourcePath  );
-	LOAD_VALUE_I(ProcessPriority   );
-	LOAD_VALUE_B(EnableSounds      );
-	LOAD_VALUE_B(DisableWarnings   );
-	LOAD_VALUE_B(NoUpdateReminder  );
-	LOAD_VALUE_B(NoSystrayWarning  );
-	LOAD_VALUE_B(SaveQueueNoConfirm);
+	LOAD_VALUE_B(AutoRunNextJob           );
+	LOAD_VALUE_U(MaxRunningJobCount       );
+	LOAD_VALUE_B(Prefer64BitSource        );
+	LOAD_VALUE_B(SaveLogFiles             );
+	LOAD_VALUE_B(SaveToSourcePath         );
+	LOAD_VALUE_I(ProcessPriority          );
+	LOAD_VALUE_B(EnableSounds             );
+	LOAD_VALUE_B(DisableWarnings          );
+	LOAD_VALUE_B(NoUpdateReminder         );
+	LOAD_VALUE_B(NoSystrayWarning         );
+	LOAD_VALUE_B(SaveQueueNoConfirm       );
+	LOAD_VALUE_B(EnableFramePump          );
+	LOAD_VALUE_U(FrameBufferCount         );
+	LOAD_VALUE_U(FrameBufferLimit         );
+	LOAD_VALUE_U(RefreshInterval          );
+	LOAD_VALUE_U(ParallelChunks           );
+	LOAD_VALUE_U(SharedSourceJobs         );
+	LOAD_VALUE_U(FirstPassLoad            );
+	LOAD_VALUE_B(EnablePreIndexing        );
+	LOAD_VALUE_U(IndexCacheQuota          );
+	LOAD_VALUE_U(ProbeThreads             );
+	LOAD_VALUE_B(EnableStreamProbe        );
+	LOAD_VALUE_B(EnableAffinityPlanner    );
+	LOAD_VALUE_B(EnableConcurrencyGovernor);
+	LOAD_VALUE_B(EnableMemoryAdmission    );
+	LOAD_VALUE_B(EnableFairShare          );
 
 	//Validation
 	preferences->setProcessPriority(qBound(-2, preferences->getProcessPriority(), 2));
 	preferences->setMaxRunningJobCount(qBound(1U, preferences->getMaxRunningJobCount(), 16U));
+	preferences->setFrameBufferCount(qBound(0U, preferences->getFrameBufferCount(), 256U));
+	preferences->setFrameBufferLimit(qBound(16U, preferences->getFrameBufferLimit(), 1024U));
+	preferences->setRefreshInterval(qBound(25U, preferences->getRefreshInterval(), 5000U));
+	preferences->setParallelChunks(qBound(0U, preferences->getParallelChunks(), 64U));
+	preferences->setSharedSourceJobs(qBound(0U, preferences->getSharedSourceJobs(), 16U));
+	preferences->setFirstPassLoad(qBound(10U, preferences->getFirstPassLoad(), 100U));
+	preferences->setIndexCacheQuota(qBound(64U, preferences->getIndexCacheQuota(), 1048576U));
+	preferences->setProbeThreads(qBound(0U, preferences->getProbeThreads(), 8U));
 }
 
 void PreferencesModel::savePreferences(PreferencesModel *preferences)
@@ -114,17 +152,32 @@ void PreferencesModel::savePreferences(PreferencesModel *preferences)
 	QSettings settings(QString("%1/preferences.ini").arg(appDir), QSettings::IniFormat);
 	settings.beginGroup("preferences");
 
-	STORE_VALUE(AutoRunNextJob    );
-	STORE_VALUE(MaxRunningJobCount);
-	STORE_VALUE(Prefer64BitSource );
-	STORE_VALUE(SaveLogFiles      );
-	STORE_VALUE(SaveToSourcePath  );
-	STORE_VALUE(ProcessPriority   );
-	STORE_VALUE(EnableSounds      );
-	STORE_VALUE(DisableWarnings   );
-	STORE_VALUE(NoUpdateReminder  );
-	STORE_VALUE(NoSystrayWarning  );
-	STORE_VALUE(SaveQueueNoConfirm);
+	STORE_VALUE(AutoRunNextJob           );
+	STORE_VALUE(MaxRunningJobCount       );
+	STORE_VALUE(Prefer64BitSource        );
+	STORE_VALUE(SaveLogFiles             );
+	STORE_VALUE(SaveToSourcePath         );
+	STORE_VALUE(ProcessPriority          );
+	STORE_VALUE(EnableSounds             );
+	STORE_VALUE(DisableWarnings          );
+	STORE_VALUE(NoUpdateReminder         );
+	STORE_VALUE(NoSystrayWarning         );
+	STORE_VALUE(SaveQueueNoConfirm       );
+	STORE_VALUE(EnableFramePump          );
+	STORE_VALUE(FrameBufferCount         );
+	STORE_VALUE(FrameBufferLimit         );
+	STORE_VALUE(RefreshInterval          );
+	STORE_VALUE(ParallelChunks           );
+	STORE_VALUE(SharedSourceJobs         );
+	STORE_VALUE(FirstPassLoad            );
+	STORE_VALUE(EnablePreIndexing        );
+	STORE_VALUE(IndexCacheQuota          );
+	STORE_VALUE(ProbeThreads             );
+	STORE_VALUE(EnableStreamProbe        );
+	STORE_VALUE(EnableAffinityPlanner    );
+	STORE_VALUE(EnableConcurrencyGovernor);
+	STORE_VALUE(EnableMemoryAdmission    );
+	STORE_VALUE(EnableFairShare          );
 	
 	settings.sync();
 }
@@ -66,6 +66,21 @@ public:
 	PREFERENCES_MAKE_B(SkipVersionTest)
 	PREFERENCES_MAKE_B(NoSystrayWarning)
 	PREFERENCES_MAKE_B(SaveQueueNoConfirm)
+	PREFERENCES_MAKE_B(EnableFramePump)
+	PREFERENCES_MAKE_U(FrameBufferCount)
+	PREFERENCES_MAKE_U(FrameBufferLimit)
+	PREFERENCES_MAKE_U(RefreshInterval)
+	PREFERENCES_MAKE_U(ParallelChunks)
+	PREFERENCES_MAKE_U(SharedSourceJobs)
+	PREFERENCES_MAKE_U(FirstPassLoad)
+	PREFERENCES_MAKE_B(EnablePreIndexing)
+	PREFERENCES_MAKE_U(IndexCacheQuota)
+	PREFERENCES_MAKE_U(ProbeThreads)
+	PREFERENCES_MAKE_B(EnableStreamProbe)
+	PREFERENCES_MAKE_B(EnableAffinityPlanner)
+	PREFERENCES_MAKE_B(EnableConcurrencyGovernor)
+	PREFERENCES_MAKE_B(EnableMemoryAdmission)
+	PREFERENCES_MAKE_B(EnableFairShare)
 
 public:
 	static void initPreferences(PreferencesModel *preferences);
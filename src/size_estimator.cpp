@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "size_estimator.h"
+
+//Internal
+#include "model_clipInfo.h"
+
+//Qt
+#include <QFileInfo>
+#include <QPair>
+
+/*
+ * The final output size is derived from the bitrate and frame counter printed by the encoder: The number of bytes
+ * written so far is "kbps * 125 * framesDone * secondsPerFrame", and dividing that by the progress gives the size
+ * of the complete file. The seconds per frame are taken from the clip info, if known, otherwise they are calibrated
+ * from the actual file size. The file system is only queried when the encoder didn't report a bitrate or when the
+ * frame rate needs to be calibrated, and never more often than once per probe interval.
+ *
+ * The individual measurements are combined by a scalar Kalman filter. Measurements taken early in the encode are
+ * assigned a large error, because the bitrate of the first frames usually isn't representative of the whole clip.
+ */
+
+static const double MIN_PROGRESS = 0.03;
+static const double MAX_REMAINING_TIME = 359999.0;
+
+// ------------------------------------------------------------
+// Constructor & Destructor
+// ------------------------------------------------------------
+
+SizeEstimator::SizeEstimator(const QString &fileName, const ClipInfo &clipInfo)
+:
+	m_fileName(fileName),
+	m_secondsPerFrame(0.0),
+	m_calibrate(true),
+	m_framesDone(0),
+	m_kbps(0.0),
+	m_bitrateValid(false),
+	m_lastSample(-1),
+	m_lastProgress(0.0)
+{
+	const QPair<quint32, quint32> frameRate = clipInfo.getFrameRate();
+	if((frameRate.first > 0) && (frameRate.second > 0))
+	{
+		m_secondsPerFrame = double(frameRate.second) / double(frameRate.first);
+		m_calibrate = false;
+	}
+
+	m_size.value = m_size.variance = 0.0;
+	m_size.valid = false;
+	m_rate.value = m_rate.variance = 0.0;
+	m_rate.valid = false;
+
+	m_timer.start();
+}
+
+SizeEstimator::~SizeEstimator(void)
+{
+	/*Nothing to do here*/
+}
+
+// ------------------------------------------------------------
+// Public Functions
+// ------------------------------------------------------------
+
+void SizeEstimator::setBitrate(const quint32 &framesDone, const double &kbps)
+{
+	m_framesDone = framesDone;
+	m_kbps = kbps;
+	m_bitrateValid = (framesDone > 0) && (kbps > 0.0);
+}
+
+void SizeEstimator::update(const double &progress)
+{
+	const double currentProgress = qBound(0.0, progress, 1.0);
+	const qint64 now = m_timer.elapsed();
+
+	//Update the rate of progress (per second), but ignore samples spanning a pause
+	if(m_lastSample >= 0)
+	{
+		const qint64 delta = now - m_lastSample;
+		if((delta > 0) && (delta <= m_maxSampleInterval) && (currentProgress > m_lastProgress))
+		{
+			filterUpdate(m_rate, (currentProgress - m_lastProgress) * 1000.0 / double(delta), 0.5, 0.01);
+		}
+	}
+	m_lastSample = now;
+	m_lastProgress = currentProgress;
+
+	if(currentProgress < MIN_PROGRESS)
+	{
+		m_bitrateValid = false;
+		return;
+	}
+
+	double bytesDone = -1.0;
+	double relativeError = (0.25 * (1.0 - currentProgress)) + 0.01;
+	qint64 fileSize = -1;
+
+	//Preferably use the bitrate reported by the encoder
+	if(m_bitrateValid)
+	{
+		const double bytesPerSecond = m_kbps * 125.0;
+		if(m_calibrate && probeFileSize(fileSize) && (fileSize > 0))
+		{
+			m_secondsPerFrame = double(fileSize) / (bytesPerSecond * double(m_framesDone));
+		}
+		if(m_secondsPerFrame > 0.0)
+		{
+			bytesDone = bytesPerSecond * double(m_framesDone) * m_secondsPerFrame;
+		}
+		m_bitrateValid = false;
+	}
+
+	//Fall back to the actual file size, which lags behind a bit due to buffering
+	if((bytesDone < 0.0) && (fileSize < 0) && probeFileSize(fileSize) && (fileSize > 0))
+	{
+		bytesDone = double(fileSize);
+		relativeError *= 2.0;
+	}
+
+	if(bytesDone > 0.0)
+	{
+		filterUpdate(m_size, bytesDone / currentProgress, relativeError, 0.002);
+	}
+}
+
+unsigned int SizeEstimator::getRemainingTime(void) const
+{
+	if(m_rate.valid && (m_rate.value > 0.0))
+	{
+		return static_cast<unsigned int>(qMin((1.0 - m_lastProgress) / m_rate.value, MAX_REMAINING_TIME));
+	}
+	return 0;
+}
+
+// ------------------------------------------------------------
+// Internal Functions
+// ------------------------------------------------------------
+
+bool SizeEstimator::probeFileSize(qint64 &fileSize)
+{
+	if(m_probeTimer.isValid() && (!m_probeTimer.hasExpired(m_probeInterval)))
+	{
+		return false;
+	}
+
+	m_probeTimer.start();
+
+	//QFileInfo caches the result of the stat() call, so this hits the file system only once
+	const QFileInfo fileInfo(m_fileName);
+	if(fileInfo.exists() && fileInfo.isFile())
+	{
+		fileSize = fileInfo.size();
+		return true;
+	}
+
+	return false;
+}
+
+void SizeEstimator::filterUpdate(filter_t &filter, const double &measurement, const double &relativeError, const double &relativeDrift)
+{
+	const double error = qMax(measurement * relativeError, 1.0e-9);
+
+	if(!filter.valid)
+	{
+		filter.value = measurement;
+		filter.variance = error * error;
+		filter.valid = true;
+		return;
+	}
+
+	//Predict: the true value may drift a little between two measurements
+	const double drift = filter.value * relativeDrift;
+	filter.variance += drift * drift;
+
+	//Correct: weight the new measurement by the Kalman gain
+	const double gain = filter.variance / (filter.variance + (error * error));
+	filter.value += gain * (measurement - filter.value);
+	filter.variance *= (1.0 - gain);
+}
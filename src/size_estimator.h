@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QElapsedTimer>
+
+class ClipInfo;
+
+class SizeEstimator
+{
+public:
+	SizeEstimator(const QString &fileName, const ClipInfo &clipInfo);
+	~SizeEstimator(void);
+
+	void setBitrate(const quint32 &framesDone, const double &kbps);
+	void update(const double &progress);
+
+	double getSize(void) const { return m_size.value; }
+	unsigned int getRemainingTime(void) const;
+
+protected:
+	static const qint64 m_probeInterval = 5000;
+	static const qint64 m_maxSampleInterval = 10000;
+
+	typedef struct
+	{
+		double value;
+		double variance;
+		bool valid;
+	}
+	filter_t;
+
+	bool probeFileSize(qint64 &fileSize);
+	static void filterUpdate(filter_t &filter, const double &measurement, const double &relativeError, const double &relativeDrift);
+
+	const QString m_fileName;
+	double m_secondsPerFrame;
+	bool m_calibrate;
+
+	quint32 m_framesDone;
+	double m_kbps;
+	bool m_bitrateValid;
+
+	filter_t m_size;
+	filter_t m_rate;
+
+	QElapsedTimer m_timer;
+	qint64 m_lastSample;
+	double m_lastProgress;
+
+	QElapsedTimer m_probeTimer;
+};
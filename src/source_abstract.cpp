@@ -26,6 +26,7 @@
 #include "model_sysinfo.h"
 #include "model_options.h"
 #include "model_preferences.h"
+#include "clipinfo_cache.h"
 
 //MUtils
 #include <MUtils/Global.h>
@@ -45,7 +46,10 @@
 AbstractSource::AbstractSource(JobObject *jobObject, const OptionsModel *options, const SysinfoModel *const sysinfo, const PreferencesModel *const preferences, JobStatus &jobStatus, volatile bool *abort, volatile bool *pause, QSemaphore *semaphorePause, const QString &sourceFile)
 :
 	AbstractTool(jobObject, options, sysinfo, preferences, jobStatus, abort, pause, semaphorePause),
-	m_sourceFile(sourceFile)
+	m_sourceFile(sourceFile),
+	m_firstFrame(0),
+	m_frameCount(0),
+	m_streamProbe(false)
 {
 	/*Nothing to do here*/
 }
@@ -64,9 +68,23 @@ bool AbstractSource::checkSourceProperties(ClipInfo &clipInfo)
 	QStringList cmdLine;
 	QList<QRegExp*> patterns;
 	QProcess process;
+	LineSplitter splitter;
 
 	checkSourceProperties_init(patterns, cmdLine);
 
+	//Properties of this script are already known and none of its dependencies has changed?
+	if(ClipInfoCache::lookup(getBinaryPath(), cmdLine, m_sourceFile, clipInfo))
+	{
+		while(!patterns.isEmpty())
+		{
+			QRegExp *pattern = patterns.takeFirst();
+			MUTILS_DELETE(pattern);
+		}
+		log(tr("Using cached clip properties of:\n%1").arg(QDir::toNativeSeparators(m_sourceFile)));
+		logSourceProperties(clipInfo);
+		return true;
+	}
+
 	log("Creating process:");
 	if(!startProcess(process, getBinaryPath(), cmdLine, true, &getExtraPaths(), &getExtraEnv()))
 	{
@@ -90,7 +108,7 @@ bool AbstractSource::checkSourceProperties(ClipInfo &clipInfo)
 			bAborted = true;
 			break;
 		}
-		if(!process.waitForReadyRead(m_processTimeoutInterval))
+		if(!waitForReadyRead(process, m_processTimeoutInterval))
 		{
 			if(process.state() == QProcess::Running)
 			{
@@ -116,12 +134,12 @@ bool AbstractSource::checkSourceProperties(ClipInfo &clipInfo)
 		}
 		
 		waitCounter = 0;
-		PROCESS_PENDING_LINES(process, checkSourceProperties_parseLine, patterns, clipInfo);
+		PROCESS_PENDING_LINES(process, splitter, checkSourceProperties_parseLine, patterns, clipInfo);
 	}
 
 	if(!(bTimeout || bAborted))
 	{
-		PROCESS_PENDING_LINES(process, checkSourceProperties_parseLine, patterns, clipInfo);
+		FLUSH_PENDING_LINES(process, splitter, checkSourceProperties_parseLine, patterns, clipInfo);
 	}
 
 	process.waitForFinished();
@@ -156,7 +174,32 @@ bool AbstractSource::checkSourceProperties(ClipInfo &clipInfo)
 		log(tr("\nFAILED TO DETERMINE CLIP PROPERTIES !!!"));
 		return false;
 	}
-	
+
+	ClipInfoCache::insert(getBinaryPath(), cmdLine, m_sourceFile, clipInfo);
+	logSourceProperties(clipInfo);
+	return true;
+}
+
+/*
+ * Clip properties of the source, as far as they are known from the cache already. Doesn't create any process.
+ */
+bool AbstractSource::lookupSourceProperties(ClipInfo &clipInfo)
+{
+	QStringList cmdLine;
+	QList<QRegExp*> patterns;
+
+	checkSourceProperties_init(patterns, cmdLine);
+	while(!patterns.isEmpty())
+	{
+		QRegExp *pattern = patterns.takeFirst();
+		MUTILS_DELETE(pattern);
+	}
+
+	return ClipInfoCache::lookup(getBinaryPath(), cmdLine, m_sourceFile, clipInfo);
+}
+
+void AbstractSource::logSourceProperties(const ClipInfo &clipInfo)
+{
 	log("");
 
 	const QPair<quint32, quint32> frameSize = clipInfo.getFrameSize();
@@ -176,16 +219,19 @@ bool AbstractSource::checkSourceProperties(ClipInfo &clipInfo)
 	}
 
 	log(tr("No. Frames: %1").arg(QString::number(clipInfo.getFrameCount())));
-	return true;
 }
 
 // ------------------------------------------------------------
 // Source Processing
 // ------------------------------------------------------------
 
-bool AbstractSource::createProcess(QProcess &processEncode, QProcess&processInput)
+bool AbstractSource::createProcess(QProcess &processEncode, QProcess&processInput, const bool &usePump)
 {
-	processInput.setStandardOutputProcess(&processEncode);
+	//Connect the processes directly, unless the frames are going to be pumped by ourselves
+	if(!usePump)
+	{
+		processInput.setStandardOutputProcess(&processEncode);
+	}
 	
 	QStringList cmdLine_Input;
 	buildCommandLine(cmdLine_Input);
@@ -196,9 +242,35 @@ bool AbstractSource::createProcess(QProcess &processEncode, QProcess&processInpu
 		return false;
 	}
 
+	if(usePump)
+	{
+		processInput.setReadChannel(QProcess::StandardOutput);
+	}
+
 	return true;
 }
 
+void AbstractSource::checkStreamProperties(QProcess &processInput, LineSplitter &splitter, ClipInfo &clipInfo, const bool &flush)
+{
+	//The frames are read from stdout, so switch over to stderr only for the time being
+	processInput.setReadChannel(QProcess::StandardError);
+	if(flush)
+	{
+		FLUSH_PENDING_LINES(processInput, splitter, checkStreamProperties_parseLine, clipInfo);
+	}
+	else
+	{
+		PROCESS_PENDING_LINES(processInput, splitter, checkStreamProperties_parseLine, clipInfo);
+	}
+	processInput.setReadChannel(QProcess::StandardOutput);
+}
+
+void AbstractSource::setFrameRange(const quint32 &firstFrame, const quint32 &frameCount)
+{
+	m_firstFrame = firstFrame;
+	m_frameCount = frameCount;
+}
+
 // ------------------------------------------------------------
 // Source Info
 // ------------------------------------------------------------
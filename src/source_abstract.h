@@ -44,8 +44,14 @@ public:
 
 	virtual bool isSourceAvailable(void) = 0;
 	virtual bool checkSourceProperties(ClipInfo &clipInfo);
-	virtual bool createProcess(QProcess &processEncode, QProcess&processInput);
+	virtual bool lookupSourceProperties(ClipInfo &clipInfo);
+	virtual bool createProcess(QProcess &processEncode, QProcess&processInput, const bool &usePump = false);
 	virtual void flushProcess(QProcess &processInput) = 0;
+	void checkStreamProperties(QProcess &processInput, LineSplitter &splitter, ClipInfo &clipInfo, const bool &flush = false);
+
+	void setFrameRange(const quint32 &firstFrame, const quint32 &frameCount);
+	void setStreamProbe(const bool &enabled) { m_streamProbe = enabled; }
+	QString getSourceBinary(void) const { return getBinaryPath(); }
 
 	static const AbstractSourceInfo& getSourceInfo(void);
 
@@ -53,9 +59,16 @@ protected:
 	virtual QHash<QString, QString> getExtraEnv(void) const;
 
 	virtual void checkSourceProperties_init(QList<QRegExp*> &patterns, QStringList &cmdLine) = 0;
-	virtual void checkSourceProperties_parseLine(const QString &line, const QList<QRegExp*> &patterns, ClipInfo &clipInfo) = 0;
+	virtual void checkSourceProperties_parseLine(const QLatin1String &rawLine, const QList<QRegExp*> &patterns, ClipInfo &clipInfo) = 0;
+	virtual void checkStreamProperties_parseLine(const QLatin1String &rawLine, ClipInfo &clipInfo) = 0;
 	
 	virtual void buildCommandLine(QStringList &cmdLine) = 0;
 
+	void logSourceProperties(const ClipInfo &clipInfo);
+
 	const QString &m_sourceFile;
+
+	quint32 m_firstFrame;
+	quint32 m_frameCount;
+	bool m_streamProbe;
 };
@@ -105,8 +105,9 @@ void AvisynthSource::checkVersion_init(QList<QRegExp*> &patterns, QStringList &c
 	patterns << new QRegExp("\\bAvs2YUV (\\d+).(\\d+)bm(\\d)\\b", Qt::CaseInsensitive);
 }
 
-void AvisynthSource::checkVersion_parseLine(const QString &line, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified)
+void AvisynthSource::checkVersion_parseLine(const QLatin1String &rawLine, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified)
 {
+	const QString line = QString::fromUtf8(rawLine.latin1());
 	int offset = -1;
 
 	if((offset = patterns[0]->lastIndexIn(line)) >= 0)
@@ -182,8 +183,9 @@ void AvisynthSource::checkSourceProperties_init(QList<QRegExp*> &patterns, QStri
 	patterns << new QRegExp(":\\s+(\\d+)\\s*x\\s*(\\d+)\\s*,\\s+\\w+\\s*,\\s+\\d+-bits\\s*,\\s+\\w+\\s*,\\s+(\\d+)\\s*/\\s*(\\d+)\\s+fps\\s*,\\s+(\\d+)\\s+frames");
 }
 
-void AvisynthSource::checkSourceProperties_parseLine(const QString &line, const QList<QRegExp*> &patterns, ClipInfo &clipInfo)
+void AvisynthSource::checkSourceProperties_parseLine(const QLatin1String &rawLine, const QList<QRegExp*> &patterns, ClipInfo &clipInfo)
 {
+	const QString line = QString::fromUtf8(rawLine.latin1());
 	int offset = -1;
 	quint32 temp[5];
 
@@ -221,6 +223,25 @@ void AvisynthSource::checkSourceProperties_parseLine(const QString &line, const
 	}
 }
 
+void AvisynthSource::checkStreamProperties_parseLine(const QLatin1String &rawLine, ClipInfo &clipInfo)
+{
+	const QString line = QString::fromUtf8(rawLine.latin1());
+
+	//Avs2YUV prints the clip properties before it starts writing the frames
+	if(clipInfo.getFrameCount() < 1)
+	{
+		QRegExp frames(",\\s+(\\d+)\\s+frames\\b", Qt::CaseInsensitive);
+		if(frames.lastIndexIn(line) >= 0)
+		{
+			bool ok = false;
+			const quint32 temp = frames.cap(1).toUInt(&ok);
+			if(ok) clipInfo.setFrameCount(temp);
+		}
+	}
+
+	log(tr("av2y [info]: %1").arg(line));
+}
+
 // ------------------------------------------------------------
 // Source Processing
 // ------------------------------------------------------------
@@ -232,6 +253,12 @@ void AvisynthSource::buildCommandLine(QStringList &cmdLine)
 		cmdLine << splitParams(m_options->customAvs2YUV());
 	}
 
+	if(m_frameCount > 0)
+	{
+		cmdLine << "-seek" << QString::number(m_firstFrame);
+		cmdLine << "-frames" << QString::number(m_frameCount);
+	}
+
 	cmdLine << QDir::toNativeSeparators(x264_path2ansi(m_sourceFile, true));
 	cmdLine << "-";
 }
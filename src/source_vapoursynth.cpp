@@ -103,8 +103,9 @@ void VapoursynthSource::checkVersion_init(QList<QRegExp*> &patterns, QStringList
 	patterns << new QRegExp("\\bAPI\\s+r(\\d+)\\b", Qt::CaseInsensitive);
 }
 
-void VapoursynthSource::checkVersion_parseLine(const QString &line, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified)
+void VapoursynthSource::checkVersion_parseLine(const QLatin1String &rawLine, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified)
 {
+	const QString line = QString::fromUtf8(rawLine.latin1());
 	int offset = -1;
 
 	if((offset = patterns[1]->lastIndexIn(line)) >= 0)
@@ -179,8 +180,9 @@ void VapoursynthSource::checkSourceProperties_init(QList<QRegExp*> &patterns, QS
 	patterns << new QRegExp("\\bFPS:\\s+(\\d+)/(\\d+)\\b");
 }
 
-void VapoursynthSource::checkSourceProperties_parseLine(const QString &line, const QList<QRegExp*> &patterns, ClipInfo &clipInfo)
+void VapoursynthSource::checkSourceProperties_parseLine(const QLatin1String &rawLine, const QList<QRegExp*> &patterns, ClipInfo &clipInfo)
 {
+	const QString line = QString::fromUtf8(rawLine.latin1());
 	int offset = -1;
 
 	if((offset = patterns[0]->lastIndexIn(line)) >= 0)
@@ -231,10 +233,43 @@ void VapoursynthSource::checkSourceProperties_parseLine(const QString &line, con
 void VapoursynthSource::buildCommandLine(QStringList &cmdLine)
 {
 	cmdLine << "--y4m";
+
+	//The progress output is the only place where VSPipe tells the number of frames while piping
+	if(m_streamProbe)
+	{
+		cmdLine << "--progress";
+	}
+
+	if(m_frameCount > 0)
+	{
+		cmdLine << "--start" << QString::number(m_firstFrame);
+		cmdLine << "--end" << QString::number(m_firstFrame + m_frameCount - 1);
+	}
+
 	cmdLine << QDir::toNativeSeparators(x264_path2ansi(m_sourceFile, true));
 	cmdLine << "-";
 }
 
+void VapoursynthSource::checkStreamProperties_parseLine(const QLatin1String &rawLine, ClipInfo &clipInfo)
+{
+	const QString line = QString::fromUtf8(rawLine.latin1());
+
+	//Progress lines look like "Frame: 123/4567", don't spam the log with them
+	if(line.startsWith(QLatin1String("Frame:"), Qt::CaseInsensitive))
+	{
+		const int offset = line.lastIndexOf(QLatin1Char('/'));
+		if(offset > 0)
+		{
+			bool ok = false;
+			const quint32 temp = line.mid(offset + 1).section(QLatin1Char(' '), 0, 0).toUInt(&ok);
+			if(ok && (temp > 0)) clipInfo.setFrameCount(temp);
+		}
+		return;
+	}
+
+	log(tr("vpyp [info]: %1").arg(line));
+}
+
 void VapoursynthSource::flushProcess(QProcess &processInput)
 {
 	while(processInput.bytesAvailable() > 0)
@@ -26,10 +26,12 @@
 #include <QTimer>
 #include <QApplication>
 #include <QDir>
+#include <QThread>
 
 //Internal
 #include "global.h"
 #include "model_sysinfo.h"
+#include "detection_cache.h"
 
 //MUtils
 #include <MUtils/Global.h>
@@ -37,6 +39,7 @@
 
 //Const
 static const bool ENABLE_PORTABLE_AVS = true;
+static const char *const AVS_CACHE_NAME = "avisynth";
 
 //Static
 QMutex AvisynthCheckThread::m_avsLock;
@@ -89,7 +92,12 @@ bool AvisynthCheckThread::detect(SysinfoModel *sysinfo)
 	QEventLoop loop;
 	AvisynthCheckThread thread(sysinfo);
 
-	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+	//May also be called from a worker thread, in which case the cursor must not be touched
+	const bool isGuiThread = (QThread::currentThread() == QApplication::instance()->thread());
+	if(isGuiThread)
+	{
+		QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+	}
 
 	connect(&thread, SIGNAL(finished()), &loop, SLOT(quit()));
 	connect(&thread, SIGNAL(terminated()), &loop, SLOT(quit()));
@@ -101,7 +109,10 @@ bool AvisynthCheckThread::detect(SysinfoModel *sysinfo)
 	loop.exec(QEventLoop::ExcludeUserInputEvents);
 	qDebug("Avisynth thread finished.");
 
-	QApplication::restoreOverrideCursor();
+	if(isGuiThread)
+	{
+		QApplication::restoreOverrideCursor();
+	}
 
 	if(!thread.wait(1000))
 	{
@@ -129,6 +140,63 @@ bool AvisynthCheckThread::detect(SysinfoModel *sysinfo)
 		qWarning("Avisynth could not be found -> Avisynth support disabled!");
 	}
 
+	//Remember the result, along with the files it depends on
+	QStringList stampFiles;
+	for(int i = 0; i < 2; i++)
+	{
+		static const char *const ARCH_DIR[] = { "x86", "x64" };
+		stampFiles << AVS_CHECK_BINARY(sysinfo, bool(i));
+		stampFiles << QString("%1/extra/Avisynth/%2/avisynth.dll").arg(QCoreApplication::applicationDirPath(), QString::fromLatin1(ARCH_DIR[i]));
+		if((thread.getSuccess() & (i ? AVISYNTH_X64 : AVISYNTH_X86)) && (!m_avsDllPath[i].isNull()))
+		{
+			stampFiles << m_avsDllPath[i]->fileName();
+		}
+	}
+	DetectionCache::insert(QString::fromLatin1(AVS_CACHE_NAME), thread.getSuccess(), QStringList() << thread.getPath(), stampFiles);
+
+	return true;
+}
+
+bool AvisynthCheckThread::loadCached(SysinfoModel *sysinfo)
+{
+	int flags = 0;
+	QStringList paths;
+	if(!DetectionCache::lookup(QString::fromLatin1(AVS_CACHE_NAME), flags, paths))
+	{
+		return false;
+	}
+
+	sysinfo->clearAvisynth();
+	sysinfo->setAvisynth(SysinfoModel::Avisynth_X86, flags & AVISYNTH_X86);
+	sysinfo->setAvisynth(SysinfoModel::Avisynth_X64, flags & AVISYNTH_X64);
+	sysinfo->setAVSPath(paths.value(0));
+	qDebug("Avisynth detection result restored from cache. [x86=%c, x64=%c]", BOOLIFY(sysinfo->getAvisynth(SysinfoModel::Avisynth_X86)), BOOLIFY(sysinfo->getAvisynth(SysinfoModel::Avisynth_X64)));
+	return true;
+}
+
+/*
+ * Repeats the detection in the background, after the cached result has been used. The detection works on a
+ * private copy of the system info, so that the cached result remains in effect until the detection is done.
+ */
+bool AvisynthCheckThread::revalidate(SysinfoModel *sysinfo)
+{
+	SysinfoModel temp;
+	temp.setAppPath(sysinfo->getAppPath());
+	temp.setCPUFeatures(SysinfoModel::CPUFeatures_X64, sysinfo->getCPUFeatures(SysinfoModel::CPUFeatures_X64));
+
+	if(!detect(&temp))
+	{
+		return false;
+	}
+
+	if((temp.getAvisynth(SysinfoModel::Avisynth_X86) != sysinfo->getAvisynth(SysinfoModel::Avisynth_X86)) || (temp.getAvisynth(SysinfoModel::Avisynth_X64) != sysinfo->getAvisynth(SysinfoModel::Avisynth_X64)))
+	{
+		qWarning("Avisynth installation has changed since the cached detection!");
+	}
+
+	sysinfo->setAvisynth(SysinfoModel::Avisynth_X86, temp.getAvisynth(SysinfoModel::Avisynth_X86));
+	sysinfo->setAvisynth(SysinfoModel::Avisynth_X64, temp.getAvisynth(SysinfoModel::Avisynth_X64));
+	sysinfo->setAVSPath(temp.getAVSPath());
 	return true;
 }
 
@@ -34,6 +34,8 @@ class AvisynthCheckThread : public StarupThread
 
 public:
 	static bool detect(SysinfoModel *sysinfo);
+	static bool loadCached(SysinfoModel *sysinfo);
+	static bool revalidate(SysinfoModel *sysinfo);
 
 protected:
 	AvisynthCheckThread(const SysinfoModel *const sysinfo);
@@ -29,6 +29,7 @@
 #include <QApplication>
 #include <QProcess>
 #include <QDir>
+#include <QtConcurrentMap>
 
 //Internal
 #include "global.h"
@@ -36,6 +37,7 @@
 #include "win_updater.h"
 #include "encoder_factory.h"
 #include "source_factory.h"
+#include "binary_manifest.h"
 
 //MUtils
 #include <MUtils/Global.h>
@@ -43,7 +45,8 @@
 
 //Static
 QMutex BinariesCheckThread::m_binLock;
-QScopedPointer<QFile> BinariesCheckThread::m_binPath[MAX_BINARIES];
+QMutex BinariesCheckThread::m_fileLock;
+QHash<QString, QSharedPointer<QFile> > BinariesCheckThread::m_binFiles;
 
 //Whatever
 #define NEXT(X) ((*reinterpret_cast<int*>(&(X)))++)
@@ -57,12 +60,12 @@ QString AVS_CHECK_BINARY(const SysinfoModel *sysinfo, const bool& x64);
 // External API
 //-------------------------------------
 
-bool BinariesCheckThread::check(const SysinfoModel *const sysinfo, QString *const failedPath)
+bool BinariesCheckThread::check(const SysinfoModel *const sysinfo, const OptionsModel::EncType &encType, QString *const failedPath)
 {
 	QMutexLocker lock(&m_binLock);
 
 	QEventLoop loop;
-	BinariesCheckThread thread(sysinfo);
+	BinariesCheckThread thread(sysinfo, encType);
 
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
@@ -101,13 +104,25 @@ bool BinariesCheckThread::check(const SysinfoModel *const sysinfo, QString *cons
 	return success;
 }
 
+/*
+ * The binaries of encoders other than the one that was selected at startup are verified on first use only.
+ * This is called by the encoding job, so the check runs synchronously (in the calling thread) here.
+ */
+bool BinariesCheckThread::checkEncoder(const SysinfoModel *const sysinfo, const OptionsModel *const options, QString *const failedPath)
+{
+	QList<binary_t> binFiles;
+	addEncoderFiles(binFiles, sysinfo, options->encType(), int(options->encArch()), int(options->encVariant()));
+	return verifyFiles(binFiles, false, failedPath);
+}
+
 //-------------------------------------
 // Thread class
 //-------------------------------------
 
-BinariesCheckThread::BinariesCheckThread(const SysinfoModel *const sysinfo)
+BinariesCheckThread::BinariesCheckThread(const SysinfoModel *const sysinfo, const OptionsModel::EncType &encType)
 :
-	m_sysinfo(sysinfo)
+	m_sysinfo(sysinfo),
+	m_encType(encType)
 {
 	m_failedPath.clear();
 }
@@ -125,90 +140,166 @@ void BinariesCheckThread::run(void)
 int BinariesCheckThread::threadMain(void)
 {
 	//Create list of all required binary files
-	typedef QPair<QString, bool> FileEntry;
-	QList<FileEntry> binFiles;
-	for(OptionsModel::EncType encdr = OptionsModel::EncType_MIN; encdr <= OptionsModel::EncType_MAX; NEXT(encdr))
-	{
-		const AbstractEncoderInfo &encInfo = EncoderFactory::getEncoderInfo(encdr);
-		const quint32 archCount = encInfo.getArchitectures().count();
-		QSet<QString> filesSet;
-		for (quint32 archIdx = 0; archIdx < archCount; ++archIdx)
-		{
-			const QStringList variants = encInfo.getVariants();
-			for (quint32 varntIdx = 0; varntIdx < quint32(variants.count()); ++varntIdx)
-			{
-				const QStringList dependencies = encInfo.getDependencies(m_sysinfo, archIdx, varntIdx);
-				for (QStringList::ConstIterator iter = dependencies.constBegin(); iter != dependencies.constEnd(); iter++)
-				{
-					if (!filesSet.contains(*iter))
-					{
-						filesSet << (*iter);
-						binFiles << qMakePair(*iter, true);
-					}
-				}
-				const QString binary = encInfo.getBinaryPath(m_sysinfo, archIdx, varntIdx);
-				if (!filesSet.contains(binary))
-				{
-					filesSet << binary;
-					binFiles << qMakePair(binary, false);
-				}
-			}
-		}
-	}
+	QList<binary_t> binFiles;
+	addEncoderFiles(binFiles, m_sysinfo, m_encType);
 	for(int i = 0; i < 2; i++)
 	{
-		binFiles << qMakePair(SourceFactory::getSourceInfo(SourceFactory::SourceType_AVS).getBinaryPath(m_sysinfo, bool(i)), false);
-		binFiles << qMakePair(AVS_CHECK_BINARY(m_sysinfo, bool(i)), false);
+		const binary_t avs2yuv = { SourceFactory::getSourceInfo(SourceFactory::SourceType_AVS).getBinaryPath(m_sysinfo, bool(i)), false, false, NULL };
+		const binary_t avsCheck = { AVS_CHECK_BINARY(m_sysinfo, bool(i)), false, false, NULL };
+		binFiles << avs2yuv << avsCheck;
 	}
 	for(size_t i = 0; UpdaterDialog::BINARIES[i].name; i++)
 	{
 		if(UpdaterDialog::BINARIES[i].exec)
 		{
-			binFiles << qMakePair(QString("%1/toolset/common/%2").arg(m_sysinfo->getAppPath(), QString::fromLatin1(UpdaterDialog::BINARIES[i].name)), false);
+			const binary_t tool = { QString("%1/toolset/common/%2").arg(m_sysinfo->getAppPath(), QString::fromLatin1(UpdaterDialog::BINARIES[i].name)), false, false, NULL };
+			binFiles << tool;
 		}
 	}
 
 	//Actually validate the binaries
-	size_t currentFile = 0;
-	for(QList<FileEntry>::ConstIterator iter = binFiles.constBegin(); iter != binFiles.constEnd(); iter++)
-	{
-		QScopedPointer<QFile> file(new QFile(iter->first));
-		qDebug("%s", MUTILS_UTF8(file->fileName()));
+	return verifyFiles(binFiles, true, &m_failedPath) ? 1 : 0;
+}
+
+//-------------------------------------
+// Verification
+//-------------------------------------
 
-		if(file->open(QIODevice::ReadOnly))
+void BinariesCheckThread::addEncoderFiles(QList<binary_t> &binFiles, const SysinfoModel *const sysinfo, const OptionsModel::EncType &encType, const int &encArch, const int &encVariant)
+{
+	const AbstractEncoderInfo &encInfo = EncoderFactory::getEncoderInfo(encType);
+	const quint32 archCount = encInfo.getArchitectures().count();
+	QSet<QString> filesSet;
+	for (quint32 archIdx = 0; archIdx < archCount; ++archIdx)
+	{
+		if((encArch >= 0) && (archIdx != quint32(encArch)))
 		{
-			if(!iter->second)
+			continue;
+		}
+		const QStringList variants = encInfo.getVariants();
+		for (quint32 varntIdx = 0; varntIdx < quint32(variants.count()); ++varntIdx)
+		{
+			if((encVariant >= 0) && (varntIdx != quint32(encVariant)))
 			{
-				if (!MUtils::OS::is_executable_file(file->fileName()))
-				{
-					m_failedPath = file->fileName();
-					qWarning("Required tool does NOT look like a valid Win32/Win64 binary:\n%s\n", MUTILS_UTF8(file->fileName()));
-					return 0;
-				}
+				continue;
 			}
-			else
+			const QStringList dependencies = encInfo.getDependencies(sysinfo, archIdx, varntIdx);
+			for (QStringList::ConstIterator iter = dependencies.constBegin(); iter != dependencies.constEnd(); iter++)
 			{
-				if (!MUtils::OS::is_library_file(file->fileName()))
+				if (!filesSet.contains(*iter))
 				{
-					m_failedPath = file->fileName();
-					qWarning("Required tool does NOT look like a valid Win32/Win64 library:\n%s\n", MUTILS_UTF8(file->fileName()));
-					return 0;
+					filesSet << (*iter);
+					const binary_t library = { *iter, true, false, NULL };
+					binFiles << library;
 				}
 			}
-			if(currentFile < MAX_BINARIES)
+			const QString binary = encInfo.getBinaryPath(sysinfo, archIdx, varntIdx);
+			if (!filesSet.contains(binary))
 			{
-				m_binPath[currentFile++].reset(file.take());
-				continue;
+				filesSet << binary;
+				const binary_t executable = { binary, false, false, NULL };
+				binFiles << executable;
+			}
+		}
+	}
+}
+
+/*
+ * Each file is opened (and kept open for the rest of the session) and checked for a valid executable or
+ * library header. The check is skipped for files that the manifest has recorded as verified, as long as
+ * their size and time stamp are unchanged. This may be called from several worker threads at once.
+ */
+void BinariesCheckThread::verifyFile(binary_t &binary)
+{
+	binary.success = false;
+	binary.file = NULL;
+
+	QScopedPointer<QFile> file(new QFile(binary.path));
+	qDebug("%s", MUTILS_UTF8(file->fileName()));
+
+	if(!file->open(QIODevice::ReadOnly))
+	{
+		qWarning("Required tool could not be found or access denied:\n%s\n", MUTILS_UTF8(file->fileName()));
+		return;
+	}
+
+	const int flag = binary.library ? BinaryManifest::FLAG_LIBRARY : BinaryManifest::FLAG_EXECUTABLE;
+	if(!BinaryManifest::isVerified(file->fileName(), flag))
+	{
+		if(!binary.library)
+		{
+			if (!MUtils::OS::is_executable_file(file->fileName()))
+			{
+				qWarning("Required tool does NOT look like a valid Win32/Win64 binary:\n%s\n", MUTILS_UTF8(file->fileName()));
+				return;
 			}
-			qFatal("Current binary file exceeds max. number of binaries!");
 		}
 		else
 		{
-			m_failedPath = file->fileName();
-			qWarning("Required tool could not be found or access denied:\n%s\n", MUTILS_UTF8(file->fileName()));
-			return 0;
+			if (!MUtils::OS::is_library_file(file->fileName()))
+			{
+				qWarning("Required tool does NOT look like a valid Win32/Win64 library:\n%s\n", MUTILS_UTF8(file->fileName()));
+				return;
+			}
+		}
+		BinaryManifest::setVerified(file->fileName(), flag);
+	}
+
+	binary.file = file.take();
+	binary.success = true;
+}
+
+bool BinariesCheckThread::verifyFiles(QList<binary_t> &binFiles, const bool &parallel, QString *const failedPath)
+{
+	//Skip all files that have been verified (and locked) in this session already
+	{
+		QMutexLocker lock(&m_fileLock);
+		QList<binary_t>::Iterator iter = binFiles.begin();
+		while(iter != binFiles.end())
+		{
+			if(m_binFiles.contains(QDir::cleanPath(iter->path).toLower()))
+			{
+				iter = binFiles.erase(iter);
+				continue;
+			}
+			iter++;
 		}
 	}
 
-	return 1;
+	if(parallel && (binFiles.count() > 1))
+	{
+		QtConcurrent::blockingMap(binFiles, verifyFile);
+	}
+	else
+	{
+		for(QList<binary_t>::Iterator iter = binFiles.begin(); iter != binFiles.end(); iter++)
+		{
+			verifyFile(*iter);
+		}
+	}
+
+	bool success = true;
+	QMutexLocker lock(&m_fileLock);
+	for(QList<binary_t>::ConstIterator iter = binFiles.constBegin(); iter != binFiles.constEnd(); iter++)
+	{
+		if(!iter->success)
+		{
+			if(success && failedPath)
+			{
+				*failedPath = iter->path;
+			}
+			success = false;
+			continue;
+		}
+		const QString key = QDir::cleanPath(iter->path).toLower();
+		if(m_binFiles.contains(key))
+		{
+			delete iter->file;
+			continue;
+		}
+		m_binFiles.insert(key, QSharedPointer<QFile>(iter->file));
+	}
+
+	BinaryManifest::save();
+	return success;
 }
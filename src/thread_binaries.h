@@ -22,9 +22,12 @@
 #pragma once
 
 #include "thread_startup.h"
+#include "model_options.h"
 
 //Qt
 #include <QMutex>
+#include <QHash>
+#include <QSharedPointer>
 
 class QLibrary;
 class SysinfoModel;
@@ -35,25 +38,41 @@ class BinariesCheckThread : public StarupThread
 	Q_OBJECT
 
 public:
-	static bool check(const SysinfoModel *const sysinfo, QString *const failedPath = NULL);
+	static bool check(const SysinfoModel *const sysinfo, const OptionsModel::EncType &encType, QString *const failedPath = NULL);
+	static bool checkEncoder(const SysinfoModel *const sysinfo, const OptionsModel *const options, QString *const failedPath = NULL);
 
 protected:
-	BinariesCheckThread(const SysinfoModel *const sysinfo);
+	BinariesCheckThread(const SysinfoModel *const sysinfo, const OptionsModel::EncType &encType);
 	~BinariesCheckThread(void);
 	
 	const QString& getFailedPath(void) { return m_failedPath; }
 
 private:
+	typedef struct
+	{
+		QString path;
+		bool library;
+		bool success;
+		QFile *file;
+	}
+	binary_t;
+
 	QString m_failedPath;
 	const SysinfoModel *const m_sysinfo;
+	const OptionsModel::EncType m_encType;
 
-	static const size_t MAX_BINARIES = 32;
 	static QMutex m_binLock;
-	static QScopedPointer<QFile> m_binPath[MAX_BINARIES];
+	static QMutex m_fileLock;
+	static QHash<QString, QSharedPointer<QFile> > m_binFiles;
 
 	//Entry point
 	virtual void run(void);
 
 	//Thread main
 	virtual int threadMain(void);
+
+	//Verification
+	static void addEncoderFiles(QList<binary_t> &binFiles, const SysinfoModel *const sysinfo, const OptionsModel::EncType &encType, const int &encArch = -1, const int &encVariant = -1);
+	static void verifyFile(binary_t &binary);
+	static bool verifyFiles(QList<binary_t> &binFiles, const bool &parallel, QString *const failedPath);
 };
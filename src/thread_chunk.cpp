@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "thread_chunk.h"
+
+//Internal
+#include "global.h"
+#include "model_options.h"
+#include "model_preferences.h"
+#include "model_sysinfo.h"
+#include "job_object.h"
+
+//Encoders
+#include "encoder_factory.h"
+
+//Source
+#include "source_factory.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+//Qt Framework
+#include <QDir>
+
+/*
+ * Macros
+ */
+#define CONNECT(OBJ) do \
+{ \
+	if((OBJ)) \
+	{ \
+		connect((OBJ), SIGNAL(statusChanged(JobStatus)),      this, SLOT(setStatus(JobStatus)),      Qt::DirectConnection); \
+		connect((OBJ), SIGNAL(progressChanged(unsigned int)), this, SLOT(setProgress(unsigned int)), Qt::DirectConnection); \
+		connect((OBJ), SIGNAL(statisticsChanged(double, unsigned int)), this, SLOT(setStatistics(double, unsigned int)), Qt::DirectConnection); \
+		connect((OBJ), SIGNAL(messageLogged(QString)),        this, SLOT(log(QString)),              Qt::DirectConnection); \
+	} \
+} \
+while(0)
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor & Destructor
+///////////////////////////////////////////////////////////////////////////////
+
+ChunkThread::ChunkThread(const unsigned int &chunkIndex, const quint32 &firstFrame, const quint32 &frameCount, const ClipInfo &clipInfo, const int &sourceType, const QString &sourceFileName, const QString &outputFileName, const OptionsModel *options, const SysinfoModel *const sysinfo, const PreferencesModel *const preferences, JobObject *const jobObject, volatile bool *abort)
+:
+	m_chunkIndex(chunkIndex),
+	m_firstFrame(firstFrame),
+	m_frameCount(frameCount),
+	m_sourceFileName(sourceFileName),
+	m_outputFileName(outputFileName),
+	m_abort(abort),
+	m_semaphorePaused(0),
+	m_encoder(NULL),
+	m_pipedSource(NULL),
+	m_clipInfo(clipInfo),
+	m_statusShared(JobStatus_Enqueued),
+	m_progressShared(0),
+	m_fpsShared(0),
+	m_etaShared(0)
+{
+	m_pause = false;
+	m_status = JobStatus_Enqueued;
+
+	//The chunk's sub-encode only ever sees its own range of frames
+	m_clipInfo.setFrameCount(m_frameCount);
+
+	//Create encoder object
+	m_encoder = EncoderFactory::createEncoder(jobObject, options, sysinfo, preferences, m_status, m_abort, &m_pause, &m_semaphorePaused, m_sourceFileName, m_outputFileName);
+
+	//Create input handler object
+	if((sourceType >= SourceFactory::SourceType_MIN) && (sourceType <= SourceFactory::SourceType_MAX))
+	{
+		m_pipedSource = SourceFactory::createSource(static_cast<SourceFactory::SourceType>(sourceType), jobObject, options, sysinfo, preferences, m_status, m_abort, &m_pause, &m_semaphorePaused, m_sourceFileName);
+		m_pipedSource->setFrameRange(m_firstFrame, m_frameCount);
+	}
+	else
+	{
+		m_encoder->setFrameRange(m_firstFrame, m_frameCount);
+	}
+
+	//Establish connections
+	CONNECT(m_encoder);
+	CONNECT(m_pipedSource);
+}
+
+ChunkThread::~ChunkThread(void)
+{
+	MUTILS_DELETE(m_encoder);
+	MUTILS_DELETE(m_pipedSource);
+}
+
+void ChunkThread::setThreadBudget(const unsigned int &threads)
+{
+	m_encoder->setThreadBudget(threads);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Encode functions
+///////////////////////////////////////////////////////////////////////////////
+
+int ChunkThread::threadMain(void)
+{
+	m_status = JobStatus_Starting;
+	m_statusShared.fetchAndStoreOrdered(JobStatus_Starting);
+
+	log(tr("Frames %1 to %2, output file: %3").arg(QString::number(m_firstFrame), QString::number(m_firstFrame + m_frameCount - 1), QDir::toNativeSeparators(m_outputFileName)));
+
+	if(m_encoder->runEncodingPass(m_pipedSource, m_outputFileName, m_clipInfo))
+	{
+		setStatus(JobStatus_Completed);
+		return 1; /*completed*/
+	}
+
+	setStatus((*m_abort) ? JobStatus_Aborted : JobStatus_Failed);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Misc functions
+///////////////////////////////////////////////////////////////////////////////
+
+void ChunkThread::log(const QString &text)
+{
+	//Keep leading line breaks in front of the prefix
+	int pos = 0;
+	while((pos < text.length()) && (text.at(pos) == QLatin1Char('\n')))
+	{
+		pos++;
+	}
+	emit messageLogged(QString("%1[Chunk %2] %3").arg(text.left(pos), QString::number(m_chunkIndex + 1), text.mid(pos)));
+}
+
+void ChunkThread::setStatus(const JobStatus &newStatus)
+{
+	m_status = newStatus;
+	m_statusShared.fetchAndStoreOrdered(newStatus);
+}
+
+void ChunkThread::setProgress(const unsigned int &newProgress)
+{
+	m_progressShared.fetchAndStoreOrdered(qBound(0U, newProgress, 100U));
+}
+
+void ChunkThread::setStatistics(const double &fps, const unsigned int &eta)
+{
+	m_fpsShared.fetchAndStoreOrdered(qRound(fps * 100.0));
+	m_etaShared.fetchAndStoreOrdered(eta);
+}
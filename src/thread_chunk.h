@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "thread_abstract.h"
+#include "model_status.h"
+#include "model_clipInfo.h"
+
+#include <QString>
+#include <QSemaphore>
+#include <QAtomicInt>
+
+class SysinfoModel;
+class PreferencesModel;
+class OptionsModel;
+class JobObject;
+class AbstractEncoder;
+class AbstractSource;
+
+class ChunkThread : public AbstractThread
+{
+	Q_OBJECT
+
+public:
+	ChunkThread(const unsigned int &chunkIndex, const quint32 &firstFrame, const quint32 &frameCount, const ClipInfo &clipInfo, const int &sourceType, const QString &sourceFileName, const QString &outputFileName, const OptionsModel *options, const SysinfoModel *const sysinfo, const PreferencesModel *const preferences, JobObject *const jobObject, volatile bool *abort);
+	~ChunkThread(void);
+
+	const QString &outputFileName(void) const { return m_outputFileName; }
+	const quint32 &firstFrame(void) const { return m_firstFrame; }
+	const quint32 &frameCount(void) const { return m_frameCount; }
+
+	JobStatus getStatus(void) const { return static_cast<JobStatus>(int(m_statusShared)); }
+	unsigned int getProgress(void) const { return static_cast<unsigned int>(int(m_progressShared)); }
+	double getFps(void) const { return double(int(m_fpsShared)) / 100.0; }
+	unsigned int getRemainingTime(void) const { return static_cast<unsigned int>(int(m_etaShared)); }
+
+	void pauseChunk(void)
+	{
+		m_pause = true;
+	}
+
+	void resumeChunk(void)
+	{
+		m_pause = false;
+		m_semaphorePaused.release();
+	}
+
+	void setThreadBudget(const unsigned int &threads);
+
+protected:
+	//Constants
+	const unsigned int m_chunkIndex;
+	const quint32 m_firstFrame;
+	const quint32 m_frameCount;
+	const QString m_sourceFileName;
+	const QString m_outputFileName;
+
+	//Flags
+	volatile bool *const m_abort;
+	volatile bool m_pause;
+
+	//Synchronization
+	QSemaphore m_semaphorePaused;
+
+	//Encoder and Source objects
+	AbstractEncoder *m_encoder;
+	AbstractSource *m_pipedSource;
+	ClipInfo m_clipInfo;
+
+	//Internal status values
+	JobStatus m_status;
+	QAtomicInt m_statusShared;
+	QAtomicInt m_progressShared;
+	QAtomicInt m_fpsShared;
+	QAtomicInt m_etaShared;
+
+	//Thread main
+	virtual int threadMain(void);
+
+signals:
+	void messageLogged(const QString &text);
+
+private slots:
+	void log(const QString &text);
+	void setStatus(const JobStatus &newStatus);
+	void setProgress(const unsigned int &newProgress);
+	void setStatistics(const double &fps, const unsigned int &eta);
+};
@@ -28,7 +28,13 @@
 #include "model_sysinfo.h"
 #include "model_clipInfo.h"
 #include "job_object.h"
+#include "affinity_planner.h"
+#include "memory_model.h"
 #include "mediainfo.h"
+#include "thread_chunk.h"
+#include "index_cache.h"
+#include "thread_preindex.h"
+#include "thread_binaries.h"
 
 //Encoders
 #include "encoder_factory.h"
@@ -51,6 +57,7 @@
 #include <QTextCodec>
 #include <QLocale>
 #include <QCryptographicHash>
+#include <QPair>
 
 /*
  * RAII execution state handler
@@ -104,6 +111,7 @@ while(0)
 		connect((OBJ), SIGNAL(statusChanged(JobStatus)),      this, SLOT(setStatus(JobStatus)),      Qt::DirectConnection); \
 		connect((OBJ), SIGNAL(progressChanged(unsigned int)), this, SLOT(setProgress(unsigned int)), Qt::DirectConnection); \
 		connect((OBJ), SIGNAL(detailsChanged(QString)),       this, SLOT(setDetails(QString)),       Qt::DirectConnection); \
+		connect((OBJ), SIGNAL(statisticsChanged(double, unsigned int)), this, SLOT(setStatistics(double, unsigned int)), Qt::DirectConnection); \
 		connect((OBJ), SIGNAL(messageLogged(QString)),        this, SLOT(log(QString)),              Qt::DirectConnection); \
 	} \
 } \
@@ -124,11 +132,29 @@ EncodeThread::EncodeThread(const QString &sourceFileName, const QString &outputF
 	m_jobObject(new JobObject),
 	m_semaphorePaused(0),
 	m_encoder(NULL),
-	m_pipedSource(NULL)
+	m_pipedSource(NULL),
+	m_sourceType(-1),
+	m_threadBudget(0),
+	m_preIndexer(NULL),
+	m_snapshotBack(0),
+	m_snapshotFront(1),
+	m_snapshotShared(2)
 {
 	m_abort = false;
 	m_pause = false;
 
+	m_status = JobStatus_Enqueued;
+	m_progress = 0;
+	m_fps = 0.0;
+	m_eta = 0;
+
+	m_probing = false;
+	m_probe.done = m_probe.success = false;
+	m_probe.encoderRevision = m_probe.sourceRevision = UINT_MAX;
+	m_probe.encoderModified = m_probe.sourceModified = false;
+	m_probe.sourceSize = m_probe.sourceTime = -1;
+	m_estimateDone = m_estimateValid = false;
+
 	//Create encoder object
 	m_encoder = EncoderFactory::createEncoder(m_jobObject, m_options, m_sysinfo, m_preferences, m_status, &m_abort, &m_pause, &m_semaphorePaused, m_sourceFileName, m_outputFileName);
 
@@ -138,12 +164,14 @@ EncodeThread::EncodeThread(const QString &sourceFileName, const QString &outputF
 	case MediaInfo::FILETYPE_AVISYNTH:
 		if(m_sysinfo->hasAvisynth())
 		{
+			m_sourceType = SourceFactory::SourceType_AVS;
 			m_pipedSource = SourceFactory::createSource(SourceFactory::SourceType_AVS, m_jobObject, m_options, m_sysinfo, m_preferences, m_status, &m_abort, &m_pause, &m_semaphorePaused, m_sourceFileName);
 		}
 		break;
 	case MediaInfo::FILETYPE_VAPOURSYNTH:
 		if(m_sysinfo->hasVapourSynth())
 		{
+			m_sourceType = SourceFactory::SourceType_VPS;
 			m_pipedSource = SourceFactory::createSource(SourceFactory::SourceType_VPS, m_jobObject, m_options, m_sysinfo, m_preferences, m_status, &m_abort, &m_pause, &m_semaphorePaused, m_sourceFileName);
 		}
 		break;
@@ -170,6 +198,15 @@ void EncodeThread::run(void)
 {
 	m_progress = 0;
 	m_status = JobStatus_Starting;
+	m_fps = 0.0;
+	m_eta = 0;
+
+	//Give this job its own set of cores, the other jobs are re-balanced
+	const bool affinityPlanner = m_jobObject && m_preferences->getEnableAffinityPlanner();
+	if(affinityPlanner)
+	{
+		AffinityPlanner::addJob(m_jobObject);
+	}
 
 	AbstractThread::run();
 
@@ -179,11 +216,29 @@ void EncodeThread::run(void)
 		setStatus(JobStatus_Failed);
 	}
 
+	//Jobs still waiting for our source can not be encoded anymore
+	while(!m_sharedOutputs.isEmpty())
+	{
+		EncodeThread *const thread = m_sharedOutputs.takeFirst();
+		thread->log(tr("The job that was going to provide the source has been stopped!"));
+		thread->finishSharedOutput(false, QDateTime::currentDateTime());
+	}
+
+	if(affinityPlanner)
+	{
+		AffinityPlanner::removeJob(m_jobObject);
+	}
+
 	if(m_jobObject)
 	{
 		m_jobObject->terminateJob(42);
 		MUTILS_DELETE(m_jobObject);
 	}
+
+	if(m_sourceType < 0)
+	{
+		IndexCache::evict(quint64(m_preferences->getIndexCacheQuota()) << 20);
+	}
 }
 
 void EncodeThread::start(Priority priority)
@@ -197,6 +252,21 @@ void EncodeThread::start(Priority priority)
 	AbstractThread::start(priority);
 }
 
+void EncodeThread::setThreadBudget(const unsigned int &threads)
+{
+	m_threadBudget = threads;
+	if(m_encoder)
+	{
+		m_encoder->setThreadBudget(threads);
+	}
+
+	//Attached jobs run within the same budget
+	for(QList<EncodeThread*>::ConstIterator iter = m_sharedOutputs.constBegin(); iter != m_sharedOutputs.constEnd(); iter++)
+	{
+		(*iter)->setThreadBudget(threads);
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Encode functions
 ///////////////////////////////////////////////////////////////////////////////
@@ -231,8 +301,28 @@ int EncodeThread::threadMain(void)
 	log(tr("Profile : %1").arg(m_options->profile()));
 	log(tr("Custom  : %1").arg(m_options->customEncParams().isEmpty() ? tr("<None>") : m_options->customEncParams()));
 	
-	bool ok = false;
+	bool ok = false, calibrate = false;
 	ClipInfo clipInfo;
+
+	//The index of our source may still be created in the background, wait for it rather than starting over
+	if(m_preIndexer && (m_sourceType < 0))
+	{
+		const QString &indexFile = m_encoder->getIndexFile();
+		if(m_preIndexer->isIndexing(indexFile))
+		{
+			log(tr("\nWaiting for the background indexer to finish, please wait..."));
+			setStatus(JobStatus_Indexing);
+		}
+		if(m_preIndexer->waitIndex(indexFile, &m_abort))
+		{
+			CHECK_STATUS(m_abort, true);
+			log(QFileInfo(indexFile).exists() ? tr("The index has been created in the background, re-using it.") : tr("The background indexer has failed, indexing the source again."));
+		}
+	}
+
+	//Wait for the look-ahead probe of this job, in case it is still running
+	QMutexLocker probeLock(&m_probeMutex);
+	const bool useProbe = isProbeValid();
 	
 	// -----------------------------------------------------------------------------------
 	// Check Versions
@@ -243,28 +333,17 @@ int EncodeThread::threadMain(void)
 	unsigned int encoderRevision = UINT_MAX, sourceRevision = UINT_MAX;
 	bool encoderModified = false, sourceModified = false;
 
-	log("Detect video encoder version:\n");
-
-	//Check encoder version
-	encoderRevision = m_encoder->checkVersion(encoderModified);
-	CHECK_STATUS(m_abort, (ok = (encoderRevision != UINT_MAX)));
-
-	//Is encoder version suppoprted?
-	CHECK_STATUS(m_abort, (ok = m_encoder->isVersionSupported(encoderRevision, encoderModified)));
-
-	if(m_pipedSource)
+	if(useProbe)
 	{
-		log("\nDetect video source version:\n");
-
-		//Is source type available?
-		CHECK_STATUS(m_abort, (ok = m_pipedSource->isSourceAvailable()));
-
-		//Checking source version
-		sourceRevision = m_pipedSource->checkVersion(sourceModified);
-		CHECK_STATUS(m_abort, (ok = (sourceRevision != UINT_MAX)));
-
-		//Is source version supported?
-		CHECK_STATUS(m_abort, (ok = m_pipedSource->isVersionSupported(sourceRevision, sourceModified)));
+		log(tr("Using the results of the look-ahead probe."));
+		encoderRevision = m_probe.encoderRevision;
+		encoderModified = m_probe.encoderModified;
+		sourceRevision = m_probe.sourceRevision;
+		sourceModified = m_probe.sourceModified;
+	}
+	else
+	{
+		CHECK_STATUS(m_abort, (ok = checkVersions(encoderRevision, encoderModified, sourceRevision, sourceModified)));
 	}
 
 	//Print tool versions
@@ -282,8 +361,33 @@ int EncodeThread::threadMain(void)
 	if(m_pipedSource)
 	{
 		log(tr("\n--- GET SOURCE INFO ---\n"));
-		ok = m_pipedSource->checkSourceProperties(clipInfo);
-		CHECK_STATUS(m_abort, ok);
+		if(useProbe && (m_probe.clipInfo.getFrameCount() > 0))
+		{
+			clipInfo = m_probe.clipInfo;
+			logClipInfo(clipInfo);
+		}
+		else if(useStreamProbe())
+		{
+			log(tr("Clip properties are going to be detected from the source stream."));
+		}
+		else
+		{
+			ok = m_pipedSource->checkSourceProperties(clipInfo);
+			CHECK_STATUS(m_abort, ok);
+		}
+	}
+	else if(MediaInfo::analyze(m_sourceFileName) == MediaInfo::FILETYPE_YUV4MPEG2)
+	{
+		log(tr("\n--- GET SOURCE INFO ---\n"));
+		if(MediaInfo::probeYuv4Mpeg(m_sourceFileName, clipInfo))
+		{
+			logClipInfo(clipInfo);
+		}
+		else
+		{
+			log(tr("Failed to parse the YUV4MPEG2 header, the clip properties are unknown."));
+			clipInfo.reset();
+		}
 	}
 
 	// -----------------------------------------------------------------------------------
@@ -291,7 +395,13 @@ int EncodeThread::threadMain(void)
 	// -----------------------------------------------------------------------------------
 
 	//Run encoding passes
-	if(m_encoder->getEncoderInfo().rcModeToType(m_options->rcMode()) == AbstractEncoderInfo::RC_TYPE_MULTIPASS)
+	if(!m_sharedOutputs.isEmpty())
+	{
+		log(tr("\n--- ENCODING VIDEO (SHARED SOURCE) ---\n"));
+		ok = runSharedEncode(clipInfo);
+		CHECK_STATUS(m_abort, ok);
+	}
+	else if(m_encoder->getEncoderInfo().rcModeToType(m_options->rcMode()) == AbstractEncoderInfo::RC_TYPE_MULTIPASS)
 	{
 		const QString passLogFile = getPasslogFile(m_outputFileName);
 		
@@ -302,12 +412,26 @@ int EncodeThread::threadMain(void)
 		log(tr("\n--- ENCODING PASS #2 ---\n"));
 		ok = m_encoder->runEncodingPass(m_pipedSource, m_outputFileName, clipInfo, 2, passLogFile);
 		CHECK_STATUS(m_abort, ok);
+		calibrate = true;
+	}
+	else if(const unsigned int chunkCount = getChunkCount(clipInfo))
+	{
+		log(tr("\n--- ENCODING VIDEO (CHUNKED) ---\n"));
+		ok = runChunkedEncode(clipInfo, chunkCount);
+		CHECK_STATUS(m_abort, ok);
 	}
 	else
 	{
 		log(tr("\n--- ENCODING VIDEO ---\n"));
 		ok = m_encoder->runEncodingPass(m_pipedSource, m_outputFileName, clipInfo);
 		CHECK_STATUS(m_abort, ok);
+		calibrate = true;
+	}
+
+	//Feed the measured peak memory usage back into the memory model (chunked and shared encodes don't fit the model)
+	if(calibrate && m_preferences->getEnableMemoryAdmission() && (clipInfo.getFrameSize().first > 0))
+	{
+		MemoryModel::calibrate(m_options, clipInfo, m_jobObject->getPeakMemoryUsage());
 	}
 
 	// -----------------------------------------------------------------------------------
@@ -323,6 +447,668 @@ int EncodeThread::threadMain(void)
 	return 1; /*completed*/
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Version and source checks
+///////////////////////////////////////////////////////////////////////////////
+
+bool EncodeThread::checkVersions(unsigned int &encoderRevision, bool &encoderModified, unsigned int &sourceRevision, bool &sourceModified)
+{
+	log("Detect video encoder version:\n");
+
+	//Binaries of the encoder are verified on first use
+	QString failedPath;
+	if(!BinariesCheckThread::checkEncoder(m_sysinfo, m_options, &failedPath))
+	{
+		log(tr("Required tool is missing or is not a valid Win32/Win64 binary:\n%1").arg(QDir::toNativeSeparators(failedPath)));
+		return false;
+	}
+
+	//Check encoder version
+	encoderRevision = m_encoder->checkVersion(encoderModified);
+	if(m_abort || (encoderRevision == UINT_MAX))
+	{
+		return false;
+	}
+
+	//Is encoder version suppoprted?
+	if(m_abort || (!m_encoder->isVersionSupported(encoderRevision, encoderModified)))
+	{
+		return false;
+	}
+
+	if(m_pipedSource)
+	{
+		log("\nDetect video source version:\n");
+
+		//Is source type available?
+		if(m_abort || (!m_pipedSource->isSourceAvailable()))
+		{
+			return false;
+		}
+
+		//Checking source version
+		sourceRevision = m_pipedSource->checkVersion(sourceModified);
+		if(m_abort || (sourceRevision == UINT_MAX))
+		{
+			return false;
+		}
+
+		//Is source version supported?
+		if(m_abort || (!m_pipedSource->isVersionSupported(sourceRevision, sourceModified)))
+		{
+			return false;
+		}
+	}
+
+	return (!m_abort);
+}
+
+void EncodeThread::logClipInfo(const ClipInfo &clipInfo)
+{
+	const QPair<quint32, quint32> frameSize = clipInfo.getFrameSize(), frameRate = clipInfo.getFrameRate();
+	log(tr("Resolution: %1 x %2").arg(QString::number(frameSize.first), QString::number(frameSize.second)));
+	log(tr("Frame Rate: %1/%2").arg(QString::number(frameRate.first), QString::number(frameRate.second)));
+	log(tr("No. Frames: %1").arg(QString::number(clipInfo.getFrameCount())));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Look-ahead probe
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The version checks and the source detection of a pending job can be run ahead of time, by a probe worker.
+ * When the job is started, it uses the stored results and can begin encoding immediately. The job waits for
+ * a probe that is still running. The results are discarded if the source file has been modified since.
+ * Returns false only if the probe has actually failed, so the job can be flagged before it is started.
+ */
+bool EncodeThread::probe(void)
+{
+	if(isRunning() || (!m_probeMutex.tryLock()))
+	{
+		return true;
+	}
+
+	if(m_probe.done)
+	{
+		m_probeMutex.unlock();
+		return m_probe.success;
+	}
+
+	m_probing = true;
+	m_encoder->setLowPriority(true);
+	if(m_pipedSource)
+	{
+		m_pipedSource->setLowPriority(true);
+	}
+
+	log(tr("--- LOOK-AHEAD PROBE ---\n"));
+	log(tr("Probe started at %1, %2.\n").arg(QDate::currentDate().toString(Qt::ISODate), QTime::currentTime().toString( Qt::ISODate)));
+
+	const QFileInfo sourceInfo(m_sourceFileName);
+	m_probe.sourceSize = sourceInfo.size();
+	m_probe.sourceTime = sourceInfo.lastModified().toMSecsSinceEpoch();
+
+	bool ok = checkVersions(m_probe.encoderRevision, m_probe.encoderModified, m_probe.sourceRevision, m_probe.sourceModified);
+	if(ok && m_pipedSource && (!useStreamProbe()))
+	{
+		log("");
+		ok = m_pipedSource->checkSourceProperties(m_probe.clipInfo) && (!m_abort);
+	}
+
+	//A cancelled probe is not a result
+	if(!m_abort)
+	{
+		m_probe.done = true;
+		m_probe.success = ok;
+		log(ok ? tr("\nProbe completed successfully.\n") : tr("\nPROBE HAS FAILED !!!\n"));
+	}
+
+	m_encoder->setLowPriority(false);
+	if(m_pipedSource)
+	{
+		m_pipedSource->setLowPriority(false);
+	}
+	m_probing = false;
+
+	m_probeMutex.unlock();
+	return ok || m_abort;
+}
+
+/*
+ * Clip properties found by the look-ahead probe, if available. Doesn't wait for a probe that is running.
+ */
+bool EncodeThread::getProbeClipInfo(ClipInfo &clipInfo)
+{
+	bool success = false;
+	if(m_probeMutex.tryLock())
+	{
+		if(m_probe.done && m_probe.success)
+		{
+			clipInfo = m_probe.clipInfo;
+			success = true;
+		}
+		m_probeMutex.unlock();
+	}
+	return success;
+}
+
+/*
+ * Clip properties for the memory admission of a pending job. Uses the results of the look-ahead probe, if
+ * available, otherwise the cached properties of the source script or the YUV4MPEG2 stream header. Doesn't
+ * create any process, so this is cheap enough to be called from the GUI thread.
+ */
+bool EncodeThread::estimateClipInfo(ClipInfo &clipInfo)
+{
+	if(getProbeClipInfo(clipInfo))
+	{
+		return true;
+	}
+
+	QMutexLocker lock(&m_estimateMutex);
+	if(!(m_estimateDone || isRunning()))
+	{
+		if(m_pipedSource)
+		{
+			m_estimateValid = m_pipedSource->lookupSourceProperties(m_estimateClipInfo);
+		}
+		else if(MediaInfo::analyze(m_sourceFileName) == MediaInfo::FILETYPE_YUV4MPEG2)
+		{
+			m_estimateValid = MediaInfo::probeYuv4Mpeg(m_sourceFileName, m_estimateClipInfo);
+		}
+		m_estimateDone = true;
+	}
+
+	if(m_estimateValid)
+	{
+		clipInfo = m_estimateClipInfo;
+	}
+	return m_estimateValid;
+}
+
+bool EncodeThread::isProbeValid(void) const
+{
+	if(!(m_probe.done && m_probe.success))
+	{
+		return false;
+	}
+
+	const QFileInfo sourceInfo(m_sourceFileName);
+	return (sourceInfo.size() == m_probe.sourceSize) && (sourceInfo.lastModified().toMSecsSinceEpoch() == m_probe.sourceTime);
+}
+
+/*
+ * In stream probe mode, the script of a piped source is not run separately to detect the clip properties.
+ * Instead, the encoder is started right away and picks up the properties from the YUV4MPEG2 stream header,
+ * while the number of frames is taken from the stderr output of the source tool. Chunked and shared source
+ * encodes need to know the clip properties in advance, so they are always probed the classic way.
+ */
+bool EncodeThread::useStreamProbe(void) const
+{
+	return m_pipedSource && m_preferences->getEnableStreamProbe() && (m_preferences->getParallelChunks() < 2) && m_sharedOutputs.isEmpty();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Background indexing
+///////////////////////////////////////////////////////////////////////////////
+
+bool EncodeThread::getIndexCommand(QString &program, QStringList &args, QString &indexFile) const
+{
+	if((m_sourceType < 0) && m_encoder->getIndexCommand(program, args))
+	{
+		indexFile = m_encoder->getIndexFile();
+		return true;
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Shared source encoding
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Jobs that encode the same piped source can share a single source process: the leading job decodes the
+ * source once and drives the encoders of all attached jobs from its own thread. Each attached job keeps its
+ * own status, log and output file, and runs the same checks as a job of its own. Jobs can only be attached
+ * before the leading job has been started. Pausing the leading job pauses the source for all attached jobs,
+ * but an attached job that is paused would stall all the others, so it is detached from the source and put
+ * back into the queue, to be encoded on its own later.
+ */
+
+bool EncodeThread::addSharedOutput(EncodeThread *const thread)
+{
+	if((thread == this) || isRunning() || thread->isRunning() || m_sharedOutputs.contains(thread) || (!canShareSource(thread)))
+	{
+		return false;
+	}
+
+	thread->m_abort = false;
+	thread->m_pause = false;
+	while(thread->m_semaphorePaused.tryAcquire(1, 0));
+
+	thread->m_progress = 0;
+	thread->m_status = JobStatus_Starting;
+	thread->m_fps = 0.0;
+	thread->m_eta = 0;
+
+	m_sharedOutputs.append(thread);
+	return true;
+}
+
+bool EncodeThread::canShareSource(const EncodeThread *const other) const
+{
+	if((!m_pipedSource) || (!other->m_pipedSource) || (m_sourceType != other->m_sourceType))
+	{
+		return false;
+	}
+
+	//The source binary (and thus its architecture) depends on the encoder settings of each job
+	if(m_pipedSource->getSourceBinary().compare(other->m_pipedSource->getSourceBinary(), Qt::CaseInsensitive) != 0)
+	{
+		return false;
+	}
+
+	if((QDir::cleanPath(m_sourceFileName).compare(QDir::cleanPath(other->m_sourceFileName), Qt::CaseInsensitive) != 0) ||
+		(QDir::cleanPath(m_outputFileName).compare(QDir::cleanPath(other->m_outputFileName), Qt::CaseInsensitive) == 0))
+	{
+		return false;
+	}
+
+	if(m_options->customAvs2YUV().compare(other->m_options->customAvs2YUV()) != 0)
+	{
+		return false;
+	}
+
+	//Multi-pass encodes need to read the source more than once
+	return (m_encoder->getEncoderInfo().rcModeToType(m_options->rcMode()) != AbstractEncoderInfo::RC_TYPE_MULTIPASS) &&
+		(other->m_encoder->getEncoderInfo().rcModeToType(other->m_options->rcMode()) != AbstractEncoderInfo::RC_TYPE_MULTIPASS);
+}
+
+bool EncodeThread::runSharedEncode(const ClipInfo &clipInfo)
+{
+	const QDateTime startTime = QDateTime::currentDateTime();
+	QList<EncodeThread*> threads;
+	QList<AbstractEncoder*> encoders;
+	encoders << m_encoder;
+
+	//Prepare the attached jobs (their encoders may be different from ours)
+	while(!m_sharedOutputs.isEmpty())
+	{
+		EncodeThread *const thread = m_sharedOutputs.takeFirst();
+		thread->setStatus(JobStatus_Starting);
+		thread->log(tr("Simple x264 Launcher (Build #%1), built %2\n").arg(QString::number(x264_version_build()), MUtils::Version::app_build_date().toString(Qt::ISODate)));
+		thread->log(tr("Job started at %1, %2.\n").arg(QDate::currentDate().toString(Qt::ISODate), QTime::currentTime().toString( Qt::ISODate)));
+		thread->log(tr("Source file : %1").arg(QDir::toNativeSeparators(thread->m_sourceFileName)));
+		thread->log(tr("Output file : %1").arg(QDir::toNativeSeparators(thread->m_outputFileName)));
+		thread->log(tr("Shared with : %1").arg(QDir::toNativeSeparators(m_outputFileName)));
+
+		//Wait for the look-ahead probe of the attached job, in case it is still running
+		thread->m_probeMutex.lock();
+
+		if(!thread->checkSharedOutput(clipInfo))
+		{
+			thread->m_probeMutex.unlock();
+			thread->finishSharedOutput(false, startTime);
+			continue;
+		}
+
+		thread->log(tr("\n--- ENCODING VIDEO (SHARED SOURCE) ---\n"));
+		threads << thread;
+		encoders << thread->m_encoder;
+	}
+
+	log(tr("Source is shared with %1 other job(s).\n").arg(QString::number(threads.count())));
+
+	//The attached jobs run their own encoder processes, so they get their own cores too
+	if(m_preferences->getEnableAffinityPlanner())
+	{
+		for(int i = 0; i < threads.count(); i++)
+		{
+			AffinityPlanner::addJob(threads.at(i)->m_jobObject);
+		}
+	}
+
+	QList<bool> results;
+	AbstractEncoder::runSharedEncodingPass(m_pipedSource, encoders, clipInfo, results);
+
+	for(int i = 0; i < threads.count(); i++)
+	{
+		AffinityPlanner::removeJob(threads.at(i)->m_jobObject);
+		threads.at(i)->m_probeMutex.unlock();
+		if(threads.at(i)->m_pause && (!threads.at(i)->m_abort))
+		{
+			threads.at(i)->detachSharedOutput();
+			continue;
+		}
+		threads.at(i)->finishSharedOutput(results.at(i + 1), startTime);
+	}
+
+	return results.first();
+}
+
+/*
+ * Run the version checks and the source checks of an attached job, just like for a job of its own. The clip
+ * properties of the attached job must agree with those of the shared source.
+ */
+bool EncodeThread::checkSharedOutput(const ClipInfo &clipInfo)
+{
+	log(tr("\n--- CHECK VERSION ---\n"));
+
+	unsigned int encoderRevision = UINT_MAX, sourceRevision = UINT_MAX;
+	bool encoderModified = false, sourceModified = false;
+	const bool useProbe = isProbeValid();
+
+	if(useProbe)
+	{
+		log(tr("Using the results of the look-ahead probe."));
+		encoderRevision = m_probe.encoderRevision;
+		encoderModified = m_probe.encoderModified;
+		sourceRevision = m_probe.sourceRevision;
+		sourceModified = m_probe.sourceModified;
+	}
+	else if(!checkVersions(encoderRevision, encoderModified, sourceRevision, sourceModified))
+	{
+		return false;
+	}
+
+	log(QString("\n> %1").arg(m_encoder->printVersion(encoderRevision, encoderModified)));
+	log(QString("> %1").arg(m_pipedSource->printVersion(sourceRevision, sourceModified)));
+
+	log(tr("\n--- GET SOURCE INFO ---\n"));
+
+	ClipInfo ownClipInfo;
+	if(useProbe && (m_probe.clipInfo.getFrameCount() > 0))
+	{
+		ownClipInfo = m_probe.clipInfo;
+		logClipInfo(ownClipInfo);
+	}
+	else if(useStreamProbe())
+	{
+		log(tr("Clip properties are going to be detected from the source stream."));
+		return !m_abort;
+	}
+	else if(m_abort || (!m_pipedSource->checkSourceProperties(ownClipInfo)))
+	{
+		return false;
+	}
+
+	if((clipInfo.getFrameCount() > 0) && ((ownClipInfo.getFrameCount() != clipInfo.getFrameCount()) || (ownClipInfo.getFrameSize() != clipInfo.getFrameSize())))
+	{
+		log(tr("\nThe clip properties differ from those of the shared source!"));
+		return false;
+	}
+
+	return !m_abort;
+}
+
+void EncodeThread::finishSharedOutput(const bool &ok, const QDateTime &startTime)
+{
+	if(m_abort || (!ok))
+	{
+		if(m_abort)
+		{
+			log("\nPROCESS ABORTED BY USER !!!");
+		}
+		setStatus(m_abort ? JobStatus_Aborted : JobStatus_Failed);
+		if(QFileInfo(m_outputFileName).exists() && (QFileInfo(m_outputFileName).size() == 0)) QFile::remove(m_outputFileName);
+		return;
+	}
+
+	log(tr("\n--- COMPLETED ---\n"));
+
+	int timePassed = startTime.secsTo(QDateTime::currentDateTime());
+	log(tr("Job finished at %1, %2. Process took %3 minutes, %4 seconds.").arg(QDate::currentDate().toString(Qt::ISODate), QTime::currentTime().toString(Qt::ISODate), QString::number(timePassed / 60), QString::number(timePassed % 60)));
+	setStatus(JobStatus_Completed);
+}
+
+void EncodeThread::detachSharedOutput(void)
+{
+	log(tr("\nJob was paused, so it has been detached from the shared source. It is going to be encoded on its own."));
+	if(QFileInfo(m_outputFileName).exists()) QFile::remove(m_outputFileName);
+
+	m_pause = false;
+	while(m_semaphorePaused.tryAcquire(1, 0));
+
+	setStatus(JobStatus_Enqueued);
+	setDetails(tr("Detached from the shared source, waiting in the queue."));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Chunked encoding
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * In chunked mode, the clip is split into consecutive frame ranges that are encoded by separate encoder
+ * instances in parallel. Each chunk starts with an IDR frame, so the raw (Annex-B) outputs of all chunks
+ * can simply be concatenated. Piped sources only render the frames of their range, via the "-seek" and
+ * "-frames" options of Avs2YUV or the "--start" and "--end" options of VSPipe, native sources are split
+ * with the "--seek" and "--frames" options of the encoder.
+ *
+ * The split points are fixed multiples of CHUNK_ALIGNMENT frames (the default keyframe interval); they are
+ * neither aligned to the keyframes the encoder would have chosen nor to scene cuts, each chunk just forces
+ * an IDR frame at its first frame. Since each chunk also runs its own rate control, chunking is restricted
+ * to the quantizer-based modes (CRF/CQP), where the chunks don't have to meet a common bitrate target.
+ */
+
+static const quint32 CHUNK_ALIGNMENT = 250U;
+static const quint32 CHUNK_MIN_FRAMES = 500U;
+static const unsigned long CHUNK_CONTROL_INTERVAL = 100UL;
+static const qint64 CHUNK_COPY_BUFFER = 4194304I64;
+
+unsigned int EncodeThread::getChunkCount(const ClipInfo &clipInfo)
+{
+	unsigned int chunkCount = m_preferences->getParallelChunks();
+	if(chunkCount < 2)
+	{
+		return 0;
+	}
+
+	if((m_options->encType() == OptionsModel::EncType_NVEnc) || (m_encoder->getEncoderInfo().rcModeToType(m_options->rcMode()) != AbstractEncoderInfo::RC_TYPE_QUANTIZER))
+	{
+		log(tr("Chunked encoding is not available for this encoder or rate-control mode, encoding in one piece."));
+		return 0;
+	}
+
+	const QString suffix = QFileInfo(m_outputFileName).suffix();
+	if((suffix.compare("264", Qt::CaseInsensitive) != 0) && (suffix.compare("hevc", Qt::CaseInsensitive) != 0))
+	{
+		log(tr("Chunked encoding requires a raw (Annex-B) output file, encoding in one piece."));
+		return 0;
+	}
+
+	if((m_sourceType < 0) && (m_options->customEncParams().contains("--seek") || m_options->customEncParams().contains("--frames")))
+	{
+		log(tr("Chunked encoding conflicts with the custom encoder parameters, encoding in one piece."));
+		return 0;
+	}
+
+	if(clipInfo.getFrameCount() < 1)
+	{
+		log(tr("Chunked encoding requires the frame count of the source, encoding in one piece."));
+		return 0;
+	}
+
+	chunkCount = qMin(chunkCount, clipInfo.getFrameCount() / CHUNK_MIN_FRAMES);
+	if(chunkCount < 2)
+	{
+		log(tr("The source is too short for chunked encoding, encoding in one piece."));
+		return 0;
+	}
+
+	return chunkCount;
+}
+
+bool EncodeThread::runChunkedEncode(const ClipInfo &clipInfo, const unsigned int &chunkCount)
+{
+	const quint32 totalFrames = clipInfo.getFrameCount();
+	const QFileInfo outputInfo(m_outputFileName);
+	volatile bool abortChunks = false;
+	QList<ChunkThread*> chunks;
+
+	//The chunks share the processors of this job
+	const unsigned int processors = (m_threadBudget > 0U) ? m_threadBudget : static_cast<unsigned int>(qMax(1, QThread::idealThreadCount()));
+	const unsigned int chunkThreads = qMax(1U, processors / chunkCount);
+
+	//Split the clip into ranges, at fixed multiples of the default keyframe interval (not at scene cuts)
+	quint32 chunkSize = (totalFrames + chunkCount - 1U) / chunkCount;
+	chunkSize = ((chunkSize + CHUNK_ALIGNMENT - 1U) / CHUNK_ALIGNMENT) * CHUNK_ALIGNMENT;
+	for(quint32 firstFrame = 0; firstFrame < totalFrames; firstFrame += chunkSize)
+	{
+		const unsigned int chunkIndex = chunks.count();
+		const QString chunkFile = QString("%1/%2.chunk%3.%4").arg(outputInfo.absolutePath(), outputInfo.completeBaseName(), QString().sprintf("%02u", chunkIndex + 1U), outputInfo.suffix());
+		ChunkThread *const chunk = new ChunkThread(chunkIndex, firstFrame, qMin(chunkSize, totalFrames - firstFrame), clipInfo, m_sourceType, m_sourceFileName, chunkFile, m_options, m_sysinfo, m_preferences, m_jobObject, &abortChunks);
+		chunk->setThreadBudget(chunkThreads);
+		connect(chunk, SIGNAL(messageLogged(QString)), this, SLOT(log(QString)), Qt::DirectConnection);
+		chunks << chunk;
+	}
+
+	log(tr("Encoding %1 frames in %2 chunks of up to %3 frames.\n").arg(QString::number(totalFrames), QString::number(chunks.count()), QString::number(chunkSize)));
+	setStatus(JobStatus_Running);
+
+	int startedChunks = 0;
+	bool paused = false;
+
+	forever
+	{
+		//Stop as soon as any chunk has failed: the remaining chunks are not started, the running ones are aborted
+		for(int i = 0; (i < startedChunks) && (!abortChunks); i++)
+		{
+			const JobStatus status = chunks.at(i)->getStatus();
+			if((status == JobStatus_Failed) || (status == JobStatus_Aborted) || (chunks.at(i)->isFinished() && (status != JobStatus_Completed)))
+			{
+				if(!m_abort)
+				{
+					log(tr("\nChunk #%1 has failed, aborting all other chunks!").arg(QString::number(i + 1)));
+				}
+				abortChunks = true;
+			}
+		}
+
+		//Start the chunks; with native sources wait until the first chunk has created the index file
+		if((!abortChunks) && (!paused) && (startedChunks < chunks.count()))
+		{
+			const JobStatus firstStatus = chunks.first()->getStatus();
+			if((startedChunks < 1) || (m_sourceType >= 0) || ((firstStatus != JobStatus_Starting) && (firstStatus != JobStatus_Indexing)))
+			{
+				while(startedChunks < chunks.count())
+				{
+					chunks.at(startedChunks++)->start();
+					if(m_sourceType < 0) break;
+				}
+			}
+		}
+
+		//Collect the progress of all chunks
+		quint64 framesDone = 0;
+		double fps = 0.0;
+		unsigned int eta = 0;
+		int runningChunks = 0;
+		for(int i = 0; i < startedChunks; i++)
+		{
+			ChunkThread *const chunk = chunks.at(i);
+			framesDone += (quint64(chunk->frameCount()) * quint64(chunk->getProgress())) / 100U;
+			if(chunk->isFinished())
+			{
+				if(chunk->getStatus() != JobStatus_Completed)
+				{
+					abortChunks = true;
+				}
+				continue;
+			}
+			fps += chunk->getFps();
+			eta = qMax(eta, chunk->getRemainingTime());
+			runningChunks++;
+		}
+
+		setProgress(static_cast<unsigned int>((framesDone * 100U) / totalFrames));
+		setStatistics(fps, eta);
+		setDetails(tr("%1 of %2 chunks running, %3 of %4 frames done, %5 fps").arg(QString::number(runningChunks), QString::number(chunks.count()), QString::number(framesDone), QString::number(totalFrames), QString::number(fps, 'f', 2)));
+
+		//Exit loop now?
+		if((runningChunks < 1) && (abortChunks || (startedChunks >= chunks.count())))
+		{
+			break;
+		}
+
+		//Propagate the abort and pause requests to the chunks
+		if(m_abort || abortChunks)
+		{
+			abortChunks = true;
+			for(int i = 0; i < startedChunks; i++)
+			{
+				chunks.at(i)->resumeChunk();
+			}
+		}
+		else if(m_pause && (!paused))
+		{
+			for(int i = 0; i < startedChunks; i++)
+			{
+				chunks.at(i)->pauseChunk();
+			}
+			paused = true;
+			setStatus(JobStatus_Paused);
+			log(tr("Job paused by user at %1, %2.").arg(QDate::currentDate().toString(Qt::ISODate), QTime::currentTime().toString( Qt::ISODate)));
+		}
+		else if((!m_pause) && paused)
+		{
+			while(m_semaphorePaused.tryAcquire(1, 0));
+			for(int i = 0; i < startedChunks; i++)
+			{
+				chunks.at(i)->resumeChunk();
+			}
+			paused = false;
+			setStatus(JobStatus_Running);
+			log(tr("Job resumed by user at %1, %2.").arg(QDate::currentDate().toString(Qt::ISODate), QTime::currentTime().toString( Qt::ISODate)));
+		}
+
+		msleep(CHUNK_CONTROL_INTERVAL);
+	}
+
+	bool ok = !abortChunks;
+
+	//Concatenate the outputs of all chunks
+	if(ok)
+	{
+		log(tr("\nConcatenating the output of %1 chunks...").arg(QString::number(chunks.count())));
+		QFile outputFile(m_outputFileName);
+		if(outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			for(QList<ChunkThread*>::ConstIterator iter = chunks.constBegin(); ok && (iter != chunks.constEnd()); iter++)
+			{
+				QFile chunkFile((*iter)->outputFileName());
+				if(!chunkFile.open(QIODevice::ReadOnly))
+				{
+					log(tr("Failed to open chunk file: %1").arg(QDir::toNativeSeparators(chunkFile.fileName())));
+					ok = false;
+					break;
+				}
+				while(ok && (!chunkFile.atEnd()))
+				{
+					const QByteArray data = chunkFile.read(CHUNK_COPY_BUFFER);
+					ok = (outputFile.write(data) == data.size());
+				}
+			}
+			outputFile.close();
+			log(ok ? tr("Done, output file size is %1 bytes.").arg(QString::number(QFileInfo(m_outputFileName).size())) : tr("Failed to write the output file!"));
+		}
+		else
+		{
+			log(tr("Failed to open output file for writing: %1").arg(QDir::toNativeSeparators(m_outputFileName)));
+			ok = false;
+		}
+	}
+
+	//Clean up
+	while(!chunks.isEmpty())
+	{
+		ChunkThread *chunk = chunks.takeFirst();
+		chunk->wait();
+		QFile::remove(chunk->outputFileName());
+		MUTILS_DELETE(chunk);
+	}
+
+	return ok;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Misc functions
 ///////////////////////////////////////////////////////////////////////////////
@@ -348,8 +1134,13 @@ void EncodeThread::setStatus(const JobStatus &newStatus)
 		{
 			setDetails("The job was aborted by the user!");
 		}
+		if(newStatus != JobStatus_Paused)
+		{
+			m_fps = 0.0;
+			m_eta = 0;
+		}
 		m_status = newStatus;
-		emit statusChanged(m_jobId, newStatus);
+		publishSnapshot();
 	}
 }
 
@@ -358,7 +1149,7 @@ void EncodeThread::setProgress(const unsigned int &newProgress)
 	if(m_progress != newProgress)
 	{
 		m_progress = newProgress;
-		emit progressChanged(m_jobId, m_progress);
+		publishSnapshot();
 	}
 }
 
@@ -366,8 +1157,18 @@ void EncodeThread::setDetails(const QString &text)
 {
 	if((!text.isEmpty()) && (m_details.compare(text) != 0))
 	{
-		emit detailsChanged(m_jobId, text);
 		m_details = text;
+		publishSnapshot();
+	}
+}
+
+void EncodeThread::setStatistics(const double &fps, const unsigned int &eta)
+{
+	if((!qFuzzyCompare(m_fps, fps)) || (m_eta != eta))
+	{
+		m_fps = fps;
+		m_eta = eta;
+		publishSnapshot();
 	}
 }
 
@@ -384,3 +1185,42 @@ QString EncodeThread::getPasslogFile(const QString &outputFile)
 
 	return passLogFile;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// Snapshot functions
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The worker thread writes its current state into the "back" buffer and then atomically swaps it with the
+ * "shared" buffer, while the GUI thread swaps its "front" buffer with the "shared" buffer whenever it finds
+ * the FRESH flag set. That way no buffer is ever accessed by both threads at the same time and neither
+ * side has to wait for the other. Intermediate states that the GUI doesn't pick up in time are dropped.
+ */
+
+static const int SNAPSHOT_INDEX = 0x3;
+static const int SNAPSHOT_FRESH = 0x4;
+
+void EncodeThread::publishSnapshot(void)
+{
+	snapshot_t &snapshot = m_snapshot[m_snapshotBack];
+
+	snapshot.status   = m_status;
+	snapshot.progress = m_progress;
+	snapshot.details  = m_details;
+	snapshot.fps      = m_fps;
+	snapshot.eta      = m_eta;
+
+	m_snapshotBack = m_snapshotShared.fetchAndStoreOrdered(m_snapshotBack | SNAPSHOT_FRESH) & SNAPSHOT_INDEX;
+}
+
+bool EncodeThread::takeSnapshot(snapshot_t &snapshot)
+{
+	if(!(int(m_snapshotShared) & SNAPSHOT_FRESH))
+	{
+		return false;
+	}
+
+	m_snapshotFront = m_snapshotShared.fetchAndStoreOrdered(m_snapshotFront) & SNAPSHOT_INDEX;
+	snapshot = m_snapshot[m_snapshotFront];
+	return true;
+}
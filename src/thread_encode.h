@@ -23,12 +23,15 @@
 
 #include "thread_abstract.h"
 #include "model_status.h"
+#include "model_clipInfo.h"
 
 #include <QThread>
 #include <QUuid>
 #include <QMutex>
 #include <QStringList>
 #include <QSemaphore>
+#include <QAtomicInt>
+#include <QList>
 
 class SysinfoModel;
 class PreferencesModel;
@@ -37,6 +40,8 @@ class QProcess;
 class JobObject;
 class AbstractEncoder;
 class AbstractSource;
+class PreIndexThread;
+class QDateTime;
 
 class EncodeThread : public AbstractThread
 {
@@ -50,6 +55,18 @@ public:
 	const QString &sourceFileName(void) const { return this->m_sourceFileName; }
 	const QString &outputFileName(void) const { return this->m_outputFileName; }
 	const OptionsModel *options(void)   const { return m_options; }
+
+	typedef struct
+	{
+		JobStatus status;
+		unsigned int progress;
+		QString details;
+		double fps;
+		unsigned int eta;
+	}
+	snapshot_t;
+
+	bool takeSnapshot(snapshot_t &snapshot);
 	
 	void pauseJob(void)
 	{
@@ -69,6 +86,16 @@ public:
 		m_semaphorePaused.release();
 	}
 
+	bool addSharedOutput(EncodeThread *const thread);
+	bool canShareSource(const EncodeThread *const other) const;
+	void setThreadBudget(const unsigned int &threads);
+	void setPreIndexer(PreIndexThread *const preIndexer) { m_preIndexer = preIndexer; }
+	bool getIndexCommand(QString &program, QStringList &args, QString &indexFile) const;
+	bool probe(void);
+	bool isProbing(void) { return m_probing; }
+	bool getProbeClipInfo(ClipInfo &clipInfo);
+	bool estimateClipInfo(ClipInfo &clipInfo);
+
 protected:
 	//Globals
 	const SysinfoModel *const m_sysinfo;
@@ -94,10 +121,53 @@ protected:
 	JobStatus m_status;
 	unsigned int m_progress;
 	QString m_details;
+	double m_fps;
+	unsigned int m_eta;
+
+	//Snapshot triple-buffer (shared with the GUI thread)
+	snapshot_t m_snapshot[3];
+	int m_snapshotBack;
+	int m_snapshotFront;
+	QAtomicInt m_snapshotShared;
 
 	//Encoder and Source objects
 	AbstractEncoder *m_encoder;
 	AbstractSource *m_pipedSource;
+	int m_sourceType;
+
+	//Jobs that share the source of this job
+	QList<EncodeThread*> m_sharedOutputs;
+
+	//Number of processors available to this job (zero means no limit)
+	unsigned int m_threadBudget;
+
+	//Background indexer, which may still be creating the index of our source
+	PreIndexThread *m_preIndexer;
+
+	//Look-ahead probe results
+	typedef struct
+	{
+		bool done;
+		bool success;
+		unsigned int encoderRevision;
+		bool encoderModified;
+		unsigned int sourceRevision;
+		bool sourceModified;
+		ClipInfo clipInfo;
+		qint64 sourceSize;
+		qint64 sourceTime;
+	}
+	probe_t;
+
+	QMutex m_probeMutex;
+	probe_t m_probe;
+	volatile bool m_probing;
+
+	//Clip properties for the memory admission, if there is no probe result
+	QMutex m_estimateMutex;
+	bool m_estimateDone;
+	bool m_estimateValid;
+	ClipInfo m_estimateClipInfo;
 
 	//Entry point
 	virtual void run(void);
@@ -105,20 +175,37 @@ protected:
 	//Thread main
 	virtual int threadMain(void);
 
+	//Version and source checks
+	bool checkVersions(unsigned int &encoderRevision, bool &encoderModified, unsigned int &sourceRevision, bool &sourceModified);
+	bool isProbeValid(void) const;
+	bool useStreamProbe(void) const;
+	void logClipInfo(const ClipInfo &clipInfo);
+
+	//Chunked encoding
+	unsigned int getChunkCount(const ClipInfo &clipInfo);
+	bool runChunkedEncode(const ClipInfo &clipInfo, const unsigned int &chunkCount);
+
+	//Shared source encoding
+	bool runSharedEncode(const ClipInfo &clipInfo);
+	bool checkSharedOutput(const ClipInfo &clipInfo);
+	void finishSharedOutput(const bool &ok, const QDateTime &startTime);
+	void detachSharedOutput(void);
+
 	//Static functions
 	static QString getPasslogFile(const QString &outputFile);
 
+	//Snapshot functions
+	void publishSnapshot(void);
+
 signals:
-	void statusChanged(const QUuid &jobId, const JobStatus &newStatus);
-	void progressChanged(const QUuid &jobId, const unsigned int &newProgress);
 	void messageLogged(const QUuid &jobId, qint64, const QString &text);
-	void detailsChanged(const QUuid &jobId, const QString &details);
 
 private slots:
 	void log(const QString &text);
 	void setStatus(const JobStatus &newStatus);
 	void setProgress(const unsigned int &newProgress);
 	void setDetails(const QString &text);
+	void setStatistics(const double &fps, const unsigned int &eta);
 
 public slots:
 	void start(Priority priority = InheritPriority);
@@ -100,7 +100,7 @@ int IPCThread_Send::threadMain(void)
 		foreach(const QString &options, args.values(CLI_PARAM_ADD_JOB))
 		{
 			const QStringList optionValues = options.split('|', QString::SkipEmptyParts);
-			if(optionValues.count() == 3)
+			if((optionValues.count() >= 3) && (optionValues.count() <= 5))
 			{
 				if(!m_ipcChannel->send(IPC_OPCODE_ADD_JOB, flags, optionValues))
 				{
@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "thread_preindex.h"
+
+//Internal
+#include "global.h"
+#include "model_preferences.h"
+#include "index_cache.h"
+#include "job_object.h"
+#include "tool_abstract.h"
+
+//MUtils
+#include <MUtils/Global.h>
+#include <MUtils/OSSupport.h>
+
+//Qt
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+
+/*
+ * Creates the index files of queued jobs in the background, before it is their turn, so that the jobs do not
+ * have to hold an encoding slot while their source is being indexed. The indexer (encoder) processes run at
+ * idle priority, one at a time. Once a job is started, all pending requests for its index file are cancelled.
+ * If an indexer is still writing that file, the job waits for it to finish (at normal priority from then on)
+ * and re-uses the index, rather than starting over. This holds for all jobs that share the same source, since
+ * the index file is named after the source.
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor & Destructor
+///////////////////////////////////////////////////////////////////////////////
+
+PreIndexThread::PreIndexThread(const PreferencesModel *const preferences)
+:
+	m_preferences(preferences),
+	m_jobObject(new JobObject)
+{
+	m_abortCurrent = false;
+	m_boostCurrent = false;
+	m_shutdown = false;
+}
+
+PreIndexThread::~PreIndexThread(void)
+{
+	shutdown();
+	MUTILS_DELETE(m_jobObject);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+void PreIndexThread::enqueue(const QUuid &jobId, const QString &program, const QStringList &args, const QString &indexFile)
+{
+	request_t request;
+	request.jobId = jobId;
+	request.program = program;
+	request.args = args;
+	request.indexFile = indexFile;
+
+	QMutexLocker lock(&m_mutex);
+	m_requests.append(request);
+	m_condition.wakeOne();
+}
+
+void PreIndexThread::cancel(const QUuid &jobId)
+{
+	QMutexLocker lock(&m_mutex);
+
+	for(QList<request_t>::Iterator iter = m_requests.begin(); iter != m_requests.end();)
+	{
+		iter = (iter->jobId == jobId) ? m_requests.erase(iter) : (iter + 1);
+	}
+
+	if(m_currentJob == jobId)
+	{
+		m_abortCurrent = true;
+	}
+}
+
+bool PreIndexThread::isIndexing(const QString &indexFile)
+{
+	QMutexLocker lock(&m_mutex);
+	return (!m_currentIndex.isEmpty()) && (m_currentIndex.compare(indexFile, Qt::CaseInsensitive) == 0);
+}
+
+/*
+ * Cancel all pending requests for the given index file. If that file is being created right now, wait until
+ * the indexer has finished, so the caller can use the index. Must be called from the job thread, not from the
+ * GUI thread. Returns true, if the indexer had to be waited for.
+ */
+bool PreIndexThread::waitIndex(const QString &indexFile, volatile bool *const abort)
+{
+	QMutexLocker lock(&m_mutex);
+
+	for(QList<request_t>::Iterator iter = m_requests.begin(); iter != m_requests.end();)
+	{
+		iter = (iter->indexFile.compare(indexFile, Qt::CaseInsensitive) == 0) ? m_requests.erase(iter) : (iter + 1);
+	}
+
+	bool waited = false;
+	while((!m_currentIndex.isEmpty()) && (m_currentIndex.compare(indexFile, Qt::CaseInsensitive) == 0) && (!(*abort)))
+	{
+		m_boostCurrent = true;
+		m_finished.wait(&m_mutex, m_processControlInterval);
+		waited = true;
+	}
+
+	return waited;
+}
+
+void PreIndexThread::shutdown(void)
+{
+	{
+		QMutexLocker lock(&m_mutex);
+		m_requests.clear();
+		m_abortCurrent = true;
+		m_shutdown = true;
+		m_condition.wakeAll();
+	}
+
+	if(isRunning())
+	{
+		wait();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Thread main
+///////////////////////////////////////////////////////////////////////////////
+
+int PreIndexThread::threadMain(void)
+{
+	forever
+	{
+		request_t request;
+		{
+			QMutexLocker lock(&m_mutex);
+			while(m_requests.isEmpty() && (!m_shutdown))
+			{
+				m_condition.wait(&m_mutex);
+			}
+			if(m_shutdown)
+			{
+				break;
+			}
+			request = m_requests.takeFirst();
+			m_currentJob = request.jobId;
+			m_currentIndex = request.indexFile;
+			m_abortCurrent = false;
+			m_boostCurrent = false;
+		}
+
+		//Create the index, unless it is in the cache already
+		if(QFileInfo(request.indexFile).exists())
+		{
+			IndexCache::touch(request.indexFile);
+		}
+		else if(runIndexer(request))
+		{
+			qDebug("[PreIndexThread] Index has been created: %s", QDir::toNativeSeparators(request.indexFile).toUtf8().constData());
+		}
+
+		{
+			QMutexLocker lock(&m_mutex);
+			m_currentJob = QUuid();
+			m_currentIndex.clear();
+			m_finished.wakeAll();
+		}
+
+		IndexCache::evict(quint64(m_preferences->getIndexCacheQuota()) << 20);
+	}
+
+	return 1;
+}
+
+bool PreIndexThread::runIndexer(const request_t &request)
+{
+	QProcess process;
+	MUtils::init_process(process, QDir::tempPath(), true);
+
+	//Must not overlap with the creation of the other processes, see AbstractTool::startProcess()
+	{
+		QMutexLocker lock(&AbstractTool::getSpawnLock());
+		process.start(request.program, request.args);
+	}
+
+	if(!process.waitForStarted())
+	{
+		qWarning("[PreIndexThread] Failed to create the indexer process!");
+		return false;
+	}
+
+	m_jobObject->addProcessToJob(&process);
+	MUtils::OS::change_process_priority(&process, -2);
+
+	bool bAborted = false, bBoosted = false;
+	while((process.state() != QProcess::NotRunning) && (!process.waitForFinished(m_processControlInterval)))
+	{
+		process.readAll();
+		if(m_boostCurrent && (!bBoosted))
+		{
+			MUtils::OS::change_process_priority(&process, 0); /*a job is waiting for this index now*/
+			bBoosted = true;
+		}
+		if(m_abortCurrent || m_shutdown)
+		{
+			process.kill();
+			process.waitForFinished(-1);
+			bAborted = true;
+			break;
+		}
+	}
+
+	//Don't leave an incomplete index behind
+	if(bAborted || (process.exitCode() != EXIT_SUCCESS))
+	{
+		QFile::remove(request.indexFile);
+		return false;
+	}
+
+	return QFileInfo(request.indexFile).exists();
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "thread_abstract.h"
+
+#include <QUuid>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+#include <QList>
+
+class PreferencesModel;
+class JobObject;
+
+class PreIndexThread : public AbstractThread
+{
+	Q_OBJECT
+
+public:
+	PreIndexThread(const PreferencesModel *const preferences);
+	~PreIndexThread(void);
+
+	void enqueue(const QUuid &jobId, const QString &program, const QStringList &args, const QString &indexFile);
+	void cancel(const QUuid &jobId);
+	bool isIndexing(const QString &indexFile);
+	bool waitIndex(const QString &indexFile, volatile bool *const abort);
+	void shutdown(void);
+
+protected:
+	static const unsigned int m_processControlInterval = 100;
+
+	typedef struct
+	{
+		QUuid jobId;
+		QString program;
+		QStringList args;
+		QString indexFile;
+	}
+	request_t;
+
+	const PreferencesModel *const m_preferences;
+	JobObject *m_jobObject;
+
+	QMutex m_mutex;
+	QWaitCondition m_condition;
+	QWaitCondition m_finished;
+	QList<request_t> m_requests;
+	QUuid m_currentJob;
+	QString m_currentIndex;
+	volatile bool m_abortCurrent;
+	volatile bool m_boostCurrent;
+	volatile bool m_shutdown;
+
+	virtual int threadMain(void);
+	bool runIndexer(const request_t &request);
+};
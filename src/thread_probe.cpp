@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "thread_probe.h"
+
+//Internal
+#include "global.h"
+#include "thread_encode.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+/*
+ * Pool of workers that run the look-ahead probe (version checks and source detection) of pending jobs at
+ * reduced priority, so that a job can start encoding as soon as it gets a slot. A job that is deleted while
+ * it is being probed has its probe aborted; cancel() returns only once the worker has released the job.
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+// Probe Queue
+///////////////////////////////////////////////////////////////////////////////
+
+ProbeQueue::ProbeQueue(const unsigned int &threadCount)
+:
+	m_shutdown(false)
+{
+	for(unsigned int i = 0; i < threadCount; i++)
+	{
+		ProbeThread *const thread = new ProbeThread(this);
+		thread->start(QThread::LowestPriority);
+		m_threads.append(thread);
+	}
+}
+
+ProbeQueue::~ProbeQueue(void)
+{
+	shutdown();
+	while(!m_threads.isEmpty())
+	{
+		ProbeThread *thread = m_threads.takeFirst();
+		MUTILS_DELETE(thread);
+	}
+}
+
+void ProbeQueue::enqueue(EncodeThread *const thread)
+{
+	QMutexLocker lock(&m_mutex);
+	if((!m_shutdown) && (!m_threads.isEmpty()) && (!m_pending.contains(thread)))
+	{
+		m_pending.append(thread);
+		m_pendingCondition.wakeOne();
+	}
+}
+
+void ProbeQueue::remove(EncodeThread *const thread)
+{
+	QMutexLocker lock(&m_mutex);
+	m_pending.removeAll(thread);
+}
+
+void ProbeQueue::cancel(EncodeThread *const thread)
+{
+	QMutexLocker lock(&m_mutex);
+	m_pending.removeAll(thread);
+
+	if(m_active.contains(thread))
+	{
+		thread->abortJob();
+		while(m_active.contains(thread))
+		{
+			m_activeCondition.wait(&m_mutex);
+		}
+	}
+}
+
+void ProbeQueue::shutdown(void)
+{
+	{
+		QMutexLocker lock(&m_mutex);
+		m_shutdown = true;
+		m_pending.clear();
+		for(QList<EncodeThread*>::ConstIterator iter = m_active.constBegin(); iter != m_active.constEnd(); iter++)
+		{
+			(*iter)->abortJob();
+		}
+		m_pendingCondition.wakeAll();
+	}
+
+	for(QList<ProbeThread*>::ConstIterator iter = m_threads.constBegin(); iter != m_threads.constEnd(); iter++)
+	{
+		(*iter)->wait();
+	}
+}
+
+bool ProbeQueue::takeNext(EncodeThread *&thread)
+{
+	QMutexLocker lock(&m_mutex);
+	while(m_pending.isEmpty() && (!m_shutdown))
+	{
+		m_pendingCondition.wait(&m_mutex);
+	}
+
+	if(m_shutdown)
+	{
+		return false;
+	}
+
+	thread = m_pending.takeFirst();
+	m_active.append(thread);
+	return true;
+}
+
+void ProbeQueue::finished(EncodeThread *const thread, const bool &success)
+{
+	const QUuid jobId = thread->getId();
+	{
+		QMutexLocker lock(&m_mutex);
+		m_active.removeAll(thread);
+		m_activeCondition.wakeAll();
+	}
+	emit probeFinished(jobId, success);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Probe Thread
+///////////////////////////////////////////////////////////////////////////////
+
+ProbeThread::ProbeThread(ProbeQueue *const queue)
+:
+	m_queue(queue)
+{
+	/*Nothing to do here*/
+}
+
+ProbeThread::~ProbeThread(void)
+{
+	/*Nothing to do here*/
+}
+
+int ProbeThread::threadMain(void)
+{
+	EncodeThread *thread = NULL;
+	while(m_queue->takeNext(thread))
+	{
+		m_queue->finished(thread, thread->probe());
+	}
+
+	return 1;
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "thread_abstract.h"
+
+#include <QObject>
+#include <QUuid>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+
+class EncodeThread;
+class ProbeThread;
+
+class ProbeQueue : public QObject
+{
+	Q_OBJECT
+
+public:
+	ProbeQueue(const unsigned int &threadCount);
+	~ProbeQueue(void);
+
+	void enqueue(EncodeThread *const thread);
+	void remove(EncodeThread *const thread);
+	void cancel(EncodeThread *const thread);
+	void shutdown(void);
+
+signals:
+	void probeFinished(const QUuid &jobId, const bool &success);
+
+protected:
+	friend class ProbeThread;
+
+	bool takeNext(EncodeThread *&thread);
+	void finished(EncodeThread *const thread, const bool &success);
+
+	QMutex m_mutex;
+	QWaitCondition m_pendingCondition;
+	QWaitCondition m_activeCondition;
+	QList<EncodeThread*> m_pending;
+	QList<EncodeThread*> m_active;
+	QList<ProbeThread*> m_threads;
+	bool m_shutdown;
+};
+
+class ProbeThread : public AbstractThread
+{
+	Q_OBJECT
+
+public:
+	ProbeThread(ProbeQueue *const queue);
+	~ProbeThread(void);
+
+protected:
+	ProbeQueue *const m_queue;
+
+	virtual int threadMain(void);
+};
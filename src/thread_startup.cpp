@@ -21,6 +21,9 @@
 
 #include "thread_startup.h"
 
+//Internal
+#include "tool_abstract.h"
+
 //MUtils
 #include <MUtils/Global.h>
 
@@ -55,8 +58,11 @@ QStringList StarupThread::runProcess(const QString &exePath, const QStringList &
 	//Setup process object
 	MUtils::init_process(process, QDir::tempPath(), true, extraPaths);
 
-	//Try to start process
-	process.start(exePath, arguments);
+	//Try to start process, must not overlap with the creation of the job processes (see AbstractTool::startProcess)
+	{
+		QMutexLocker lock(&AbstractTool::getSpawnLock());
+		process.start(exePath, arguments);
+	}
 	if (!process.waitForStarted())
 	{
 		qWarning("Failed to launch %s -> %s", MUTILS_UTF8(fileName), MUTILS_UTF8(process.errorString()));
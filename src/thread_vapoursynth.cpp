@@ -31,11 +31,13 @@
 #include <QApplication>
 #include <QDir>
 #include <QHash>
+#include <QThread>
 #include <QAbstractFileEngine.h>
 
 //Internal
 #include "global.h"
 #include "model_sysinfo.h"
+#include "detection_cache.h"
 
 //CRT
 #include <cassert>
@@ -51,6 +53,7 @@ static const char* const VPS_EXE_NAME = "vspipe.exe";
 static const char* const VPS_REG_KEY1 = "SOFTWARE\\VapourSynth";
 static const char* const VPS_REG_KEY2 = "SOFTWARE\\VapourSynth-32";
 static const char* const VPS_REG_NAME = "VapourSynthDLL";
+static const char* const VPS_CACHE_NAME = "vapoursynth";
 
 //Default VapurSynth architecture
 #if _WIN64 || __x86_64__
@@ -85,7 +88,12 @@ bool VapourSynthCheckThread::detect(SysinfoModel* sysinfo)
 	QEventLoop loop;
 	VapourSynthCheckThread thread;
 
-	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+	//May also be called from a worker thread, in which case the cursor must not be touched
+	const bool isGuiThread = (QThread::currentThread() == QApplication::instance()->thread());
+	if (isGuiThread)
+	{
+		QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+	}
 
 	connect(&thread, SIGNAL(finished()), &loop, SLOT(quit()));
 	connect(&thread, SIGNAL(terminated()), &loop, SLOT(quit()));
@@ -97,7 +105,10 @@ bool VapourSynthCheckThread::detect(SysinfoModel* sysinfo)
 	loop.exec(QEventLoop::ExcludeUserInputEvents);
 	qDebug("VapourSynth thread finished.");
 
-	QApplication::restoreOverrideCursor();
+	if (isGuiThread)
+	{
+		QApplication::restoreOverrideCursor();
+	}
 
 	if (!thread.wait(1000))
 	{
@@ -114,6 +125,20 @@ bool VapourSynthCheckThread::detect(SysinfoModel* sysinfo)
 	}
 
 	const int success = thread.getSuccess();
+
+	//Remember the result, along with the files it depends on
+	QStringList stampFiles;
+	for (size_t i = 0; i < 2U; i++)
+	{
+		const QDir vpsPortableDir(QString("%1/extra/VapourSynth-%2").arg(QCoreApplication::applicationDirPath(), QString::number(VPS_BITNESS(i))));
+		stampFiles << vpsPortableDir.absoluteFilePath(VPS_DLL_NAME) << vpsPortableDir.absoluteFilePath(VPS_EXE_NAME);
+		if ((success & (i ? VAPOURSYNTH_X64 : VAPOURSYNTH_X86)) && (!m_vpsExePath[i].isNull()) && (!m_vpsDllPath[i].isNull()))
+		{
+			stampFiles << m_vpsExePath[i]->fileName() << m_vpsDllPath[i]->fileName();
+		}
+	}
+	DetectionCache::insert(QString::fromLatin1(VPS_CACHE_NAME), success, QStringList() << thread.getPath32() << thread.getPath64(), stampFiles);
+
 	if (!success)
 	{
 		qWarning("VapourSynth could not be found -> VapourSynth support disabled!");
@@ -136,6 +161,62 @@ bool VapourSynthCheckThread::detect(SysinfoModel* sysinfo)
 	return true;
 }
 
+bool VapourSynthCheckThread::loadCached(SysinfoModel *sysinfo)
+{
+	int flags = 0;
+	QStringList paths;
+	if (!DetectionCache::lookup(QString::fromLatin1(VPS_CACHE_NAME), flags, paths))
+	{
+		return false;
+	}
+
+	sysinfo->clearVapourSynth();
+	sysinfo->clearVPS32Path();
+	sysinfo->clearVPS64Path();
+
+	if (flags & VAPOURSYNTH_X86)
+	{
+		sysinfo->setVapourSynth(SysinfoModel::VapourSynth_X86, true);
+		sysinfo->setVPS32Path(paths.value(0));
+	}
+
+	if (flags & VAPOURSYNTH_X64)
+	{
+		sysinfo->setVapourSynth(SysinfoModel::VapourSynth_X64, true);
+		sysinfo->setVPS64Path(paths.value(1));
+	}
+
+	qDebug("VapourSynth detection result restored from cache. [x86=%c, x64=%c]", BOOLIFY(sysinfo->getVapourSynth(SysinfoModel::VapourSynth_X86)), BOOLIFY(sysinfo->getVapourSynth(SysinfoModel::VapourSynth_X64)));
+	return true;
+}
+
+/*
+ * Repeats the detection in the background, after the cached result has been used. The detection works on a
+ * private copy of the system info, so that the cached result remains in effect until the detection is done.
+ */
+bool VapourSynthCheckThread::revalidate(SysinfoModel *sysinfo)
+{
+	SysinfoModel temp;
+	temp.setAppPath(sysinfo->getAppPath());
+	temp.setCPUFeatures(SysinfoModel::CPUFeatures_X64, sysinfo->getCPUFeatures(SysinfoModel::CPUFeatures_X64));
+
+	if (!detect(&temp))
+	{
+		return false;
+	}
+
+	if ((temp.getVapourSynth(SysinfoModel::VapourSynth_X86) != sysinfo->getVapourSynth(SysinfoModel::VapourSynth_X86)) || (temp.getVapourSynth(SysinfoModel::VapourSynth_X64) != sysinfo->getVapourSynth(SysinfoModel::VapourSynth_X64)))
+	{
+		qWarning("VapourSynth installation has changed since the cached detection!");
+	}
+
+	sysinfo->setVapourSynth(SysinfoModel::VapourSynth_X86, temp.getVapourSynth(SysinfoModel::VapourSynth_X86));
+	sysinfo->setVapourSynth(SysinfoModel::VapourSynth_X64, temp.getVapourSynth(SysinfoModel::VapourSynth_X64));
+	sysinfo->setVPS32Path(temp.getVPS32Path());
+	sysinfo->setVPS64Path(temp.getVPS64Path());
+	return true;
+}
+
 //-------------------------------------
 // Thread functions
 //-------------------------------------
@@ -36,6 +36,8 @@ class VapourSynthCheckThread : public StarupThread
 
 public:
 	static bool detect(SysinfoModel *sysinfo);
+	static bool loadCached(SysinfoModel *sysinfo);
+	static bool revalidate(SysinfoModel *sysinfo);
 
 protected:
 	typedef enum _VapourSynthFlags
@@ -27,6 +27,7 @@
 #include "model_preferences.h"
 #include "model_sysinfo.h"
 #include "job_object.h"
+#include "version_cache.h"
 
 //MUtils
 #include <MUtils/OSSupport.h>
@@ -36,6 +37,7 @@
 #include <QMutexLocker>
 #include <QDir>
 #include <QCryptographicHash>
+#include <QElapsedTimer>
 
 QMutex AbstractTool::s_mutexStartProcess;
 
@@ -69,7 +71,8 @@ AbstractTool::AbstractTool(JobObject *jobObject, const OptionsModel *options, co
 	m_jobStatus(jobStatus),
 	m_abort(abort),
 	m_pause(pause),
-	m_semaphorePause(semaphorePause)
+	m_semaphorePause(semaphorePause),
+	m_lowPriority(false)
 {
 	/*nothing to do here*/
 }
@@ -89,10 +92,24 @@ unsigned int AbstractTool::checkVersion(bool &modified)
 	QProcess process;
 	QList<QRegExp*> patterns;
 	QStringList cmdLine;
+	LineSplitter splitter;
 
 	//Init encoder-specific values
 	checkVersion_init(patterns, cmdLine);
 
+	//Re-use the result of an earlier check, as long as the binary is unchanged
+	unsigned int cachedRevision = UINT_MAX;
+	if(VersionCache::lookup(getBinaryPath(), cmdLine, cachedRevision, modified))
+	{
+		log(tr("Using cached version info of:\n%1").arg(QDir::toNativeSeparators(getBinaryPath())));
+		while(!patterns.isEmpty())
+		{
+			QRegExp *pattern = patterns.takeFirst();
+			MUTILS_DELETE(pattern);
+		}
+		return cachedRevision;
+	}
+
 	log("Creating process:");
 	if(!startProcess(process, getBinaryPath(), cmdLine, true, &getExtraPaths(), &getExtraEnv()))
 	{
@@ -114,9 +131,9 @@ unsigned int AbstractTool::checkVersion(bool &modified)
 			bAborted = true;
 			break;
 		}
-		if(!process.waitForReadyRead())
+		if(!waitForReadyRead(process, m_processVersionTimeout))
 		{
-			if(process.state() == QProcess::Running)
+			if((process.state() == QProcess::Running) && (!(*m_abort)))
 			{
 				process.kill();
 				qWarning("process timed out <-- killing!");
@@ -125,12 +142,12 @@ unsigned int AbstractTool::checkVersion(bool &modified)
 				break;
 			}
 		}
-		PROCESS_PENDING_LINES(process, checkVersion_parseLine, patterns, coreVers, revision, modified);
+		PROCESS_PENDING_LINES(process, splitter, checkVersion_parseLine, patterns, coreVers, revision, modified);
 	}
 
 	if(!(bTimeout || bAborted))
 	{
-		PROCESS_PENDING_LINES(process, checkVersion_parseLine, patterns, coreVers, revision, modified);
+		FLUSH_PENDING_LINES(process, splitter, checkVersion_parseLine, patterns, coreVers, revision, modified);
 	}
 
 	process.waitForFinished();
@@ -161,7 +178,9 @@ unsigned int AbstractTool::checkVersion(bool &modified)
 		return UINT_MAX;
 	}
 	
-	return makeRevision(coreVers, revision);
+	const unsigned int result = makeRevision(coreVers, revision);
+	VersionCache::insert(getBinaryPath(), cmdLine, result, modified);
+	return result;
 }
 
 bool AbstractTool::checkVersion_succeeded(const int &exitCode)
@@ -173,9 +192,14 @@ bool AbstractTool::checkVersion_succeeded(const int &exitCode)
 // Process Creation
 // ------------------------------------------------------------
 
+/*
+ * The pipes of the new process are created and handed to CreateProcess() inside of QProcess::start(). Since the
+ * handles are inheritable, a process that is created at the same time by another thread would inherit them too,
+ * and the pipes would not be closed when our process exits. Hence the global lock must cover QProcess::start(),
+ * but nothing else: the start-up handshake, the job object and the priority don't affect any other process.
+ */
 bool AbstractTool::startProcess(QProcess &process, const QString &program, const QStringList &args, bool mergeChannels, const QStringList *const extraPaths, const QHash<QString, QString> *const extraEnv)
 {
-	QMutexLocker lock(&s_mutexStartProcess);
 	log(commandline2string(program, args) + "\n");
 
 	MUtils::init_process(process, QDir::tempPath(), true, extraPaths, extraEnv);
@@ -185,13 +209,22 @@ bool AbstractTool::startProcess(QProcess &process, const QString &program, const
 		process.setReadChannel(QProcess::StandardError);
 	}
 
-	process.start(program, args);
+	QElapsedTimer timer;
+	timer.start();
+	qint64 lockWait = 0, spawnTime = 0;
+
+	{
+		QMutexLocker lock(&s_mutexStartProcess);
+		lockWait = timer.elapsed();
+		process.start(program, args);
+		spawnTime = timer.elapsed() - lockWait;
+	}
 	
 	if(process.waitForStarted())
 	{
 		m_jobObject->addProcessToJob(&process);
-		MUtils::OS::change_process_priority(&process, m_preferences->getProcessPriority());
-		lock.unlock();
+		MUtils::OS::change_process_priority(&process, m_lowPriority ? -2 : m_preferences->getProcessPriority());
+		log(tr("Process started after %1 ms (spawn lock: %2 ms, spawn: %3 ms).\n").arg(QString::number(timer.elapsed()), QString::number(lockWait), QString::number(spawnTime)));
 		return true;
 	}
 
@@ -204,6 +237,133 @@ bool AbstractTool::startProcess(QProcess &process, const QString &program, const
 	return false;
 }
 
+// ------------------------------------------------------------
+// Process Output
+// ------------------------------------------------------------
+
+bool AbstractTool::waitForReadyRead(QProcess &process, const int &timeout, const bool &interruptOnPause)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	//Wait in short slices, so that abort (and pause) requests take effect promptly
+	forever
+	{
+		const qint64 remaining = qint64(timeout) - timer.elapsed();
+		if(remaining <= 0)
+		{
+			return false;
+		}
+		if(process.waitForReadyRead(int(qMin(remaining, qint64(m_processControlInterval)))))
+		{
+			return true;
+		}
+		if((*m_abort) || (interruptOnPause && (*m_pause)) || (process.state() != QProcess::Running))
+		{
+			return false;
+		}
+	}
+}
+
+// ------------------------------------------------------------
+// Line Splitter
+// ------------------------------------------------------------
+
+bool LineSplitter::readLine(QProcess &process, const char *&line)
+{
+	forever
+	{
+		//Hand out the next complete line, if any
+		while(m_start < m_fill)
+		{
+			qint64 end = m_start;
+			while((end < m_fill) && (m_buffer[end] != '\r') && (m_buffer[end] != '\n'))
+			{
+				end++;
+			}
+			if(end >= m_fill)
+			{
+				break;
+			}
+			const qint64 start = m_start;
+			m_start = end + 1;
+			if(*(line = simplify(start, end)))
+			{
+				return true;
+			}
+		}
+
+		//Move the incomplete line to the front of the buffer
+		if(m_start > 0)
+		{
+			memmove(m_buffer, m_buffer + m_start, size_t(m_fill - m_start));
+			m_fill -= m_start;
+			m_start = 0;
+		}
+
+		//Line does not fit into the buffer, so it has to be split
+		if(m_fill >= m_capacity)
+		{
+			m_start = m_fill;
+			if(*(line = simplify(0, m_fill)))
+			{
+				return true;
+			}
+			continue;
+		}
+
+		if(process.bytesAvailable() < 1)
+		{
+			return false;
+		}
+
+		const qint64 len = process.read(m_buffer + m_fill, m_capacity - m_fill);
+		if(len <= 0)
+		{
+			return false;
+		}
+		m_fill += len;
+	}
+}
+
+bool LineSplitter::flush(const char *&line)
+{
+	if(m_start < m_fill)
+	{
+		line = simplify(m_start, m_fill);
+		m_start = m_fill = 0;
+		return (*line != '\0');
+	}
+	return false;
+}
+
+const char *LineSplitter::simplify(const qint64 &start, const qint64 &end)
+{
+	char *const out = m_buffer + start;
+	qint64 len = 0;
+	bool space = false;
+
+	//Collapse all white-spaces in-place, like QString::simplified() does
+	for(qint64 pos = start; pos < end; pos++)
+	{
+		const char c = m_buffer[pos];
+		if((c == ' ') || (c == '\t') || (c == '\v') || (c == '\f'))
+		{
+			space = (len > 0);
+			continue;
+		}
+		if(space)
+		{
+			out[len++] = ' ';
+			space = false;
+		}
+		out[len++] = c;
+	}
+
+	out[len] = '\0';
+	return out;
+}
+
 // ------------------------------------------------------------
 // Utilities
 // ------------------------------------------------------------
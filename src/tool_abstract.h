@@ -53,31 +53,41 @@ public:
 	virtual bool isVersionSupported(const unsigned int &revision, const bool &modified) = 0;
 	virtual QString printVersion(const unsigned int &revision, const bool &modified) = 0;
 
+	void setLowPriority(const bool &enabled) { m_lowPriority = enabled; }
+
+	static QMutex &getSpawnLock(void) { return s_mutexStartProcess; }
+
 signals:
 	void statusChanged(const JobStatus &newStatus);
 	void progressChanged(unsigned int newProgress);
 	void messageLogged(const QString &text);
 	void detailsChanged(const QString &details);
+	void statisticsChanged(const double &fps, const unsigned int &eta);
 
 protected:
 	static const unsigned int m_processTimeoutInterval = 2500;
 	static const unsigned int m_processTimeoutMaxCounter = 120;
 	static const unsigned int m_processTimeoutWarning = 24;
+	static const unsigned int m_processVersionTimeout = 30000;
+	static const unsigned int m_processControlInterval = 50;
 
 	virtual QString getBinaryPath(void) const = 0;
 	virtual QHash<QString, QString> getExtraEnv(void) const { return QHash<QString, QString>(); }
 	virtual QStringList getExtraPaths(void) const { return QStringList(); }
 
 	virtual void checkVersion_init(QList<QRegExp*> &patterns, QStringList &cmdLine) = 0;
-	virtual void checkVersion_parseLine(const QString &line, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified) = 0;
+	virtual void checkVersion_parseLine(const QLatin1String &rawLine, const QList<QRegExp*> &patterns, unsigned int &core, unsigned int &build, bool &modified) = 0;
 	virtual bool checkVersion_succeeded(const int &exitCode);
 
 	void log(const QString &text) { emit messageLogged(text); }
+	void log(const QLatin1String &line) { emit messageLogged(QString::fromUtf8(line.latin1())); }
 	void setStatus(const JobStatus &newStatus) { emit statusChanged(newStatus); } 
 	void setProgress(unsigned int newProgress) { emit progressChanged(newProgress); }
 	void setDetails(const QString &text) { emit detailsChanged(text); }
+	void setStatistics(const double &fps, const unsigned int &eta) { emit statisticsChanged(fps, eta); }
 
 	bool startProcess(QProcess &process, const QString &program, const QStringList &args, bool mergeChannels = true, const QStringList *const extraPath = NULL, const QHash<QString, QString> *const extraEnv = NULL);
+	bool waitForReadyRead(QProcess &process, const int &timeout, const bool &interruptOnPause = false);
 
 	JobObject *const m_jobObject;
 	const OptionsModel *const m_options;
@@ -87,6 +97,7 @@ protected:
 	volatile bool *const m_abort;
 	volatile bool *const m_pause;
 	QSemaphore *const m_semaphorePause;
+	bool m_lowPriority;
 
 	static QString commandline2string(const QString &program, const QStringList &arguments);
 	static QStringList splitParams(const QString &params, const QString &sourceFile = QString(), const QString &outputFile = QString());
@@ -97,20 +108,49 @@ protected:
 	static QMutex s_mutexStartProcess;
 };
 
+// ------------------------------------------------------------
+// Line Splitter
+// ------------------------------------------------------------
+
+class LineSplitter
+{
+public:
+	LineSplitter(void) : m_start(0), m_fill(0) {/*NOP*/}
+
+	bool readLine(QProcess &process, const char *&line);
+	bool flush(const char *&line);
+
+protected:
+	static const qint64 m_capacity = 4096;
+
+	const char *simplify(const qint64 &start, const qint64 &end);
+
+	char m_buffer[m_capacity + 1];
+	qint64 m_start;
+	qint64 m_fill;
+};
+
 // ------------------------------------------------------------
 // Helper Macros
 // ------------------------------------------------------------
 
-#define PROCESS_PENDING_LINES(PROC, HANDLER, ...) do \
+#define PROCESS_PENDING_LINES(PROC, SPLITTER, HANDLER, ...) do \
+{ \
+	const char *_line = NULL; \
+	while((SPLITTER).readLine((PROC), _line)) \
+	{ \
+		HANDLER(QLatin1String(_line), __VA_ARGS__); \
+	} \
+} \
+while(0)
+
+#define FLUSH_PENDING_LINES(PROC, SPLITTER, HANDLER, ...) do \
 { \
-	while((PROC).bytesAvailable() > 0) \
+	PROCESS_PENDING_LINES(PROC, SPLITTER, HANDLER, __VA_ARGS__); \
+	const char *_rest = NULL; \
+	if((SPLITTER).flush(_rest)) \
 	{ \
-		QList<QByteArray> lines = (PROC).readLine().split('\r'); \
-		while(!lines.isEmpty()) \
-		{ \
-			const QString text = QString::fromUtf8(lines.takeFirst().constData()).simplified(); \
-			HANDLER(text, __VA_ARGS__); \
-		} \
+		HANDLER(QLatin1String(_rest), __VA_ARGS__); \
 	} \
 } \
 while(0)
@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////////
+// Simple x264 Launcher
+// Copyright (C) 2004-2020 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "version_cache.h"
+
+//Internal
+#include "global.h"
+
+//Qt
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSettings>
+#include <QMutex>
+#include <QHash>
+#include <QCryptographicHash>
+
+//CRT
+#include <climits>
+
+/*
+ * Results of the tool version checks are cached in the data path, so that the tools don't need to be run for
+ * every job. An entry is keyed by the binary path and the command-line of the check. It is valid as long as
+ * the size, the modification time and the content hash (SHA-1) of the binary match. The content hash of each
+ * binary is computed only once per session, the result is kept in memory along with the size and time stamp.
+ */
+
+static const char *const KEY_SIZE     = "size";
+static const char *const KEY_TIME     = "time";
+static const char *const KEY_DIGEST   = "digest";
+static const char *const KEY_REVISION = "revision";
+static const char *const KEY_MODIFIED = "modified";
+
+static const qint64 HASH_BUFFER_SIZE = 1048576I64;
+
+typedef struct
+{
+	qint64 size;
+	qint64 time;
+	QString digest;
+}
+file_stamp_t;
+
+static QMutex g_versionCacheMutex;
+static QHash<QString, file_stamp_t> g_fileStamps;
+
+bool VersionCache::lookup(const QString &binaryPath, const QStringList &args, unsigned int &revision, bool &modified)
+{
+	QMutexLocker lock(&g_versionCacheMutex);
+
+	qint64 size = -1, time = -1;
+	QString digest;
+	if(!getFileStamp(binaryPath, size, time, digest))
+	{
+		return false;
+	}
+
+	QSettings settings(getCacheFile(), QSettings::IniFormat);
+	settings.beginGroup(getEntryKey(binaryPath, args));
+
+	const bool valid = (settings.value(KEY_SIZE, -1).toLongLong() == size) && (settings.value(KEY_TIME, -1).toLongLong() == time) && (settings.value(KEY_DIGEST).toString().compare(digest, Qt::CaseInsensitive) == 0);
+	if(valid && settings.contains(KEY_REVISION))
+	{
+		revision = settings.value(KEY_REVISION, UINT_MAX).toUInt();
+		modified = settings.value(KEY_MODIFIED, false).toBool();
+		return (revision != UINT_MAX);
+	}
+
+	return false;
+}
+
+void VersionCache::insert(const QString &binaryPath, const QStringList &args, const unsigned int &revision, const bool &modified)
+{
+	QMutexLocker lock(&g_versionCacheMutex);
+
+	qint64 size = -1, time = -1;
+	QString digest;
+	if(!getFileStamp(binaryPath, size, time, digest))
+	{
+		return;
+	}
+
+	QSettings settings(getCacheFile(), QSettings::IniFormat);
+	settings.beginGroup(getEntryKey(binaryPath, args));
+	settings.setValue(KEY_SIZE, size);
+	settings.setValue(KEY_TIME, time);
+	settings.setValue(KEY_DIGEST, digest);
+	settings.setValue(KEY_REVISION, revision);
+	settings.setValue(KEY_MODIFIED, modified);
+	settings.endGroup();
+	settings.sync();
+}
+
+QString VersionCache::getEntryKey(const QString &binaryPath, const QStringList &args)
+{
+	const QString key = QString("%1|%2").arg(QDir::cleanPath(QFileInfo(binaryPath).absoluteFilePath()).toLower(), args.join(QString("|")));
+	return QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex().constData());
+}
+
+bool VersionCache::getFileStamp(const QString &binaryPath, qint64 &size, qint64 &time, QString &digest)
+{
+	const QFileInfo fileInfo(binaryPath);
+	if(!fileInfo.isFile())
+	{
+		return false;
+	}
+
+	size = fileInfo.size();
+	time = fileInfo.lastModified().toMSecsSinceEpoch();
+
+	//Content hash is already known for this version of the file?
+	const QString path = QDir::cleanPath(fileInfo.absoluteFilePath()).toLower();
+	if(g_fileStamps.contains(path))
+	{
+		const file_stamp_t &stamp = g_fileStamps[path];
+		if((stamp.size == size) && (stamp.time == time))
+		{
+			digest = stamp.digest;
+			return true;
+		}
+	}
+
+	QFile file(fileInfo.absoluteFilePath());
+	if(!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("[VersionCache] Failed to open file for hashing!");
+		return false;
+	}
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	while(!file.atEnd())
+	{
+		const QByteArray buffer = file.read(HASH_BUFFER_SIZE);
+		if(buffer.isEmpty())
+		{
+			break;
+		}
+		hash.addData(buffer);
+	}
+	file.close();
+
+	file_stamp_t stamp;
+	stamp.size = size;
+	stamp.time = time;
+	stamp.digest = digest = QString::fromLatin1(hash.result().toHex().constData());
+	g_fileStamps.insert(path, stamp);
+	return true;
+}
+
+QString VersionCache::getCacheFile(void)
+{
+	return QString("%1/version_cache.ini").arg(x264_data_path());
+}
@@ -36,7 +36,11 @@
 #include "thread_binaries.h"
 #include "thread_vapoursynth.h"
 #include "thread_encode.h"
+#include "encoder_factory.h"
 #include "thread_ipc_recv.h"
+#include "concurrency_governor.h"
+#include "memory_model.h"
+#include "model_clipInfo.h"
 #include "input_filter.h"
 #include "win_addJob.h"
 #include "win_about.h"
@@ -56,6 +60,7 @@
 
 //Qt
 #include <QDate>
+#include <QDateTime>
 #include <QTimer>
 #include <QCloseEvent>
 #include <QMessageBox>
@@ -72,6 +77,8 @@
 #include <QSystemTrayIcon>
 #include <QMovie>
 #include <QTextDocument>
+#include <QtConcurrentRun>
+#include <QFutureWatcher>
 #include <ctime>
 
 //Constants
@@ -82,6 +89,8 @@ static const char *avs_dl_url = "http://sourceforge.net/projects/avisynth2/files
 static const char *python_url = "https://www.python.org/downloads/";
 static const char *vsynth_url = "http://www.vapoursynth.com/";
 static const int   vsynth_rev = 24;
+static const int   mem_retry  = 10000;
+static const int   mem_settle = 30000;
 
 //Macros
 #define SET_FONT_BOLD(WIDGET,BOLD) do { QFont _font = WIDGET->font(); _font.setBold(BOLD); WIDGET->setFont(_font); } while(0)
@@ -164,7 +173,15 @@ MainWindow::MainWindow(const MUtils::CPUFetaures::cpu_info_t &cpuFeatures, MUtil
 	//Create model
 	m_jobList.reset(new JobListModel(m_preferences.data()));
 	connect(m_jobList.data(), SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(jobChangedData(QModelIndex, QModelIndex)));
+	connect(m_jobList.data(), SIGNAL(jobStatusChanged(QModelIndex, JobStatus)), this, SLOT(jobStatusChanged(QModelIndex, JobStatus)));
 	ui->jobsView->setModel(m_jobList.data());
+
+	//Create concurrency governor
+	if(m_preferences->getEnableConcurrencyGovernor())
+	{
+		m_governor.reset(new ConcurrencyGovernor(m_jobList.data(), m_preferences.data()));
+		connect(m_governor.data(), SIGNAL(limitChanged()), this, SLOT(launchNextJob()));
+	}
 	
 	//Setup view
 	ui->jobsView->horizontalHeader()->setSectionHidden(3, true);
@@ -308,6 +325,9 @@ MainWindow::MainWindow(const MUtils::CPUFetaures::cpu_info_t &cpuFeatures, MUtil
 	//Create timer
 	m_fileTimer.reset(new QTimer(this));
 	connect(m_fileTimer.data(), SIGNAL(timeout()), this, SLOT(handlePendingFiles()));
+	m_admissionTimer.reset(new QTimer(this));
+	m_admissionTimer->setSingleShot(true);
+	connect(m_admissionTimer.data(), SIGNAL(timeout()), this, SLOT(launchNextJob()));
 }
 
 /*
@@ -342,7 +362,7 @@ void MainWindow::addButtonPressed()
 	ENSURE_APP_IS_READY();
 
 	qDebug("MainWindow::addButtonPressed");
-	bool runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? m_preferences->getMaxRunningJobCount() : 1));
+	bool runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? getRunningJobLimit() : 1));
 	QString sourceFileName, outputFileName;
 
 	if(createJob(sourceFileName, outputFileName, m_options.data(), runImmediately))
@@ -369,7 +389,7 @@ void MainWindow::openActionTriggered()
 		}
 		else
 		{
-			bool runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? m_preferences->getMaxRunningJobCount() : 1));
+			bool runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? getRunningJobLimit() : 1));
 			QString sourceFileName(fileList.first()), outputFileName;
 			if(createJob(sourceFileName, outputFileName, m_options.data(), runImmediately))
 			{
@@ -455,7 +475,7 @@ void MainWindow::postOpActionTriggered(void)
 void MainWindow::startButtonPressed(void)
 {
 	ENSURE_APP_IS_READY();
-	m_jobList->startJob(ui->jobsView->currentIndex());
+	startJob(ui->jobsView->currentIndex());
 }
 
 /*
@@ -567,7 +587,7 @@ void MainWindow::restartButtonPressed(void)
 
 	if((options) && (!sourceFileName.isEmpty()) && (!outputFileName.isEmpty()))
 	{
-		bool runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? m_preferences->getMaxRunningJobCount() : 1));
+		bool runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? getRunningJobLimit() : 1));
 		OptionsModel *tempOptions = new OptionsModel(*options);
 		if(createJob(sourceFileName, outputFileName, tempOptions, runImmediately, true))
 		{
@@ -638,11 +658,6 @@ void MainWindow::jobChangedData(const QModelIndex &topLeft, const  QModelIndex &
 				updateButtons(status);
 				updateTaskbar(status, m_jobList->data(m_jobList->index(i, 0, QModelIndex()), Qt::DecorationRole).value<QIcon>());
 			}
-			if((status == JobStatus_Completed) || (status == JobStatus_Failed))
-			{
-				if(m_preferences->getAutoRunNextJob()) QTimer::singleShot(0, this, SLOT(launchNextJob()));
-				if(m_preferences->getSaveLogFiles()) saveLogFile(m_jobList->index(i, 1, QModelIndex()));
-			}
 		}
 	}
 	if(topLeft.column() <= 2 && bottomRight.column() >= 2) /*PROGRESS*/
@@ -673,6 +688,56 @@ void MainWindow::jobChangedData(const QModelIndex &topLeft, const  QModelIndex &
 	}
 }
 
+/*
+ * Handle job status transitions
+ */
+void MainWindow::jobStatusChanged(const QModelIndex &index, const JobStatus &newStatus)
+{
+	//A job that has just started encoding has not allocated its memory yet, so keep it reserved for a while
+	if(m_preferences->getEnableMemoryAdmission() && ((newStatus == JobStatus_Running) || (newStatus == JobStatus_Running_Pass1) || (newStatus == JobStatus_Running_Pass2)))
+	{
+		m_settlingJobs.insert(m_jobList->getJobId(index), QDateTime::currentMSecsSinceEpoch());
+	}
+
+	if((newStatus == JobStatus_Completed) || (newStatus == JobStatus_Failed))
+	{
+		if(m_preferences->getAutoRunNextJob()) QTimer::singleShot(0, this, SLOT(launchNextJob()));
+		else resumeHeldJob();
+		if(m_preferences->getSaveLogFiles()) saveLogFile(m_jobList->index(index.row(), 1, QModelIndex()));
+	}
+	else if(newStatus == JobStatus_Aborted)
+	{
+		resumeHeldJob();
+	}
+	else if(newStatus == JobStatus_Paused)
+	{
+		//A held job has finished pausing, a full slot may have become available in the meantime
+		if(m_heldJobs.contains(m_jobList->getJobId(index)))
+		{
+			if(m_preferences->getAutoRunNextJob()) QTimer::singleShot(0, this, SLOT(launchNextJob()));
+			else resumeHeldJob();
+		}
+	}
+	else if(newStatus == JobStatus_Running_Pass1)
+	{
+		//A job in its first pass occupies only a fraction of a slot, so another job may fit in now
+		if(m_preferences->getAutoRunNextJob()) QTimer::singleShot(0, this, SLOT(launchNextJob()));
+	}
+	else if(newStatus == JobStatus_Running_Pass2)
+	{
+		//The second pass needs a full slot, so hold the job until a slot becomes available
+		if(countFullSlots() > getRunningJobLimit())
+		{
+			const QUuid jobId = m_jobList->getJobId(index);
+			if(m_jobList->pauseJob(index))
+			{
+				qDebug("Second pass does not fit into the slots, holding the job!");
+				m_heldJobs << jobId;
+			}
+		}
+	}
+}
+
 /*
  * Handle new log file content
  */
@@ -734,26 +799,108 @@ void MainWindow::launchNextJob(void)
 {
 	qDebug("Launching next job...");
 
-	if(countRunningJobs() >= m_preferences->getMaxRunningJobCount())
+	//Jobs that have been paused by the governor take precedence over new jobs
+	if((!m_governor.isNull()) && m_governor->resumeJob())
+	{
+		qDebug("Resumed a paused job instead!");
+		return;
+	}
+
+	//Jobs that are held before their second pass take precedence over new jobs too
+	if(resumeHeldJob())
+	{
+		qDebug("Resumed a held job instead!");
+		return;
+	}
+	if(hasPausedHeldJobs())
+	{
+		qDebug("Jobs are still waiting for their second pass, won't launch next one yet!");
+		return;
+	}
+
+	const double maxSlots = static_cast<double>(getRunningJobLimit());
+	const double runningSlots = countRunningSlots();
+
+	if(runningSlots >= maxSlots)
 	{
 		qDebug("Still have too many jobs running, won't launch next one yet!");
 		return;
 	}
 
-	const int rows = m_jobList->rowCount(QModelIndex());
+	//With no job running, nothing would ever free up memory, so the next job is always admitted
+	const bool memoryAdmission = m_preferences->getEnableMemoryAdmission() && (runningSlots > 0.0);
+	const quint64 memoryHeadroom = memoryAdmission ? getMemoryHeadroom() : 0;
+	bool deferred = false;
 
-	for(int i = 0; i < rows; i++)
+	if(m_preferences->getEnableFairShare())
 	{
-		const QModelIndex currentIndex = m_jobList->index(i, 0, QModelIndex());
-		if(m_jobList->getJobStatus(currentIndex) == JobStatus_Enqueued)
+		//The scheduler decides which job goes next, jobs that can't be started yet are handed back to it
+		QList<QUuid> deferredJobs;
+		bool started = false, stopped = false;
+		while(!(started || stopped))
 		{
-			if(m_jobList->startJob(currentIndex))
+			const QModelIndex currentIndex = m_jobList->takeNextJob();
+			if(!currentIndex.isValid())
+			{
+				break;
+			}
+			switch(checkAdmission(currentIndex, runningSlots, maxSlots, memoryAdmission, memoryHeadroom))
+			{
+			case ADMISSION_STOP:
+				m_jobList->requeueJob(currentIndex);
+				stopped = true;
+				break;
+			case ADMISSION_DEFER:
+				deferredJobs << m_jobList->getJobId(currentIndex);
+				break;
+			default:
+				started = startJob(currentIndex);
+				if(started)
+				{
+					ui->jobsView->selectRow(currentIndex.row());
+				}
+				break;
+			}
+		}
+		for(QList<QUuid>::ConstIterator iter = deferredJobs.constBegin(); iter != deferredJobs.constEnd(); iter++)
+		{
+			m_jobList->requeueJob(m_jobList->getJobIndexById(*iter));
+		}
+		if(started || stopped)
+		{
+			return;
+		}
+		deferred = !deferredJobs.isEmpty();
+	}
+	else
+	{
+		for(QModelIndex currentIndex = m_jobList->nextEnqueuedJob(QModelIndex()); currentIndex.isValid(); currentIndex = m_jobList->nextEnqueuedJob(currentIndex))
+		{
+			switch(checkAdmission(currentIndex, runningSlots, maxSlots, memoryAdmission, memoryHeadroom))
+			{
+			case ADMISSION_STOP:
+				return;
+			case ADMISSION_DEFER:
+				deferred = true;
+				continue;
+			default:
+				break;
+			}
+			if(startJob(currentIndex))
 			{
 				ui->jobsView->selectRow(currentIndex.row());
 				return;
 			}
 		}
 	}
+
+	if(deferred)
+	{
+		//Memory may also be freed by an aborted job or by other processes, so check again in a while
+		qDebug("Enqueued jobs are waiting for memory to become available!");
+		m_admissionTimer->start(mem_retry);
+		return;
+	}
 		
 	qWarning("No enqueued jobs left to be started!");
 
@@ -896,7 +1043,7 @@ void MainWindow::init(void)
 		
 	qDebug("[Validating binaries]");
 	QString failedPath;
-	if(!BinariesCheckThread::check(m_sysinfo.data(), &failedPath))
+	if(!BinariesCheckThread::check(m_sysinfo.data(), m_options->encType(), &failedPath))
 	{
 		QMessageBox::critical(this, tr("Invalid File!"), tr("<nobr>At least one tool is missing or is not a valid Win32/Win64 binary:</nobr><br><tt>%1</tt><br><br><nobr>Please re-install the program in order to fix the problem!</nobr>").replace("-", "&minus;").arg(Qt::escape(QDir::toNativeSeparators(failedPath))));
 		qFatal("At least one tool is missing or is not a valid Win32/Win64 binary. Program will exit now!");
@@ -968,14 +1115,55 @@ void MainWindow::init(void)
 
 	qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
 
+	//---------------------------------------
+	// Detect Avisynth and VapourSynth
+	//---------------------------------------
+
+	const bool checkAvs = !arguments.contains(CLI_PARAM_SKIP_AVS_CHECK);
+	const bool checkVps = !arguments.contains(CLI_PARAM_SKIP_VPS_CHECK);
+
+	//Start from the cached results, where still valid, and detect everything else concurrently
+	qDebug("[Check for Avisynth and VapourSynth support]");
+	const bool avsCached = checkAvs && AvisynthCheckThread::loadCached(m_sysinfo.data());
+	const bool vpsCached = checkVps && VapourSynthCheckThread::loadCached(m_sysinfo.data());
+	QFutureWatcher<bool> avsDetection, vpsDetection;
+	if(checkAvs && (!avsCached))
+	{
+		avsDetection.setFuture(QtConcurrent::run(AvisynthCheckThread::detect, m_sysinfo.data()));
+	}
+	if(checkVps && (!vpsCached))
+	{
+		vpsDetection.setFuture(QtConcurrent::run(VapourSynthCheckThread::detect, m_sysinfo.data()));
+	}
+	if(!(avsDetection.isFinished() && vpsDetection.isFinished()))
+	{
+		QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+		while(!(avsDetection.isFinished() && vpsDetection.isFinished()))
+		{
+			qApp->processEvents(QEventLoop::ExcludeUserInputEvents | QEventLoop::WaitForMoreEvents);
+		}
+		QApplication::restoreOverrideCursor();
+	}
+	qDebug(" ");
+
+	//Cached results are confirmed in the background, the detection will update them if anything has changed
+	if(avsCached)
+	{
+		m_revalidation.addFuture(QtConcurrent::run(AvisynthCheckThread::revalidate, m_sysinfo.data()));
+	}
+	if(vpsCached)
+	{
+		m_revalidation.addFuture(QtConcurrent::run(VapourSynthCheckThread::revalidate, m_sysinfo.data()));
+	}
+
 	//---------------------------------------
 	// Check Avisynth support
 	//---------------------------------------
 
-	if(!arguments.contains(CLI_PARAM_SKIP_AVS_CHECK))
+	if(checkAvs)
 	{
 		qDebug("[Check for Avisynth support]");
-		if(!AvisynthCheckThread::detect(m_sysinfo.data()))
+		if((!avsCached) && (!avsDetection.result()))
 		{
 			QString text = tr("A critical error was encountered while checking your Avisynth version.").append("<br>");
 			text += tr("This is most likely caused by an erroneous Avisynth Plugin, please try to clean your Plugins folder!").append("<br>");
@@ -1001,10 +1189,10 @@ void MainWindow::init(void)
 	// Check VapurSynth support
 	//---------------------------------------
 
-	if(!arguments.contains(CLI_PARAM_SKIP_VPS_CHECK))
+	if(checkVps)
 	{
 		qDebug("[Check for VapourSynth support]");
-		if(!VapourSynthCheckThread::detect(m_sysinfo.data()))
+		if((!vpsCached) && (!vpsDetection.result()))
 		{
 			QString text = tr("A critical error was encountered while checking your VapourSynth installation.").append("<br>");
 			text += tr("This is most likely caused by an erroneous VapourSynth Plugin, please try to clean your Filters folder!").append("<br>");
@@ -1257,7 +1445,7 @@ void MainWindow::handleCommand(const int &command, const QStringList &args, cons
 			if(QFileInfo(args[0]).exists() && QFileInfo(args[0]).isFile())
 			{
 				OptionsModel options(m_sysinfo.data());
-				bool runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? m_preferences->getMaxRunningJobCount() : 1));
+				bool runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? getRunningJobLimit() : 1));
 				if(!(args[2].isEmpty() || X264_STRCMP(args[2], "-")))
 				{
 					if(!OptionsModel::loadTemplate(&options, args[2].trimmed()))
@@ -1265,9 +1453,26 @@ void MainWindow::handleCommand(const int &command, const QStringList &args, cons
 						qWarning("Template '%s' could not be found -> using defaults!", args[2].trimmed().toUtf8().constData());
 					}
 				}
+				//Optional priority and submitter, the submitter may carry its fair share weight as "<name>:<weight>"
+				const int priority = (args.size() >= 4) ? args[3].trimmed().toInt() : 0;
+				QString submitter;
+				if(args.size() >= 5)
+				{
+					const QStringList submitterParts = args[4].split(':');
+					submitter = submitterParts.first().trimmed();
+					if(submitterParts.count() > 1)
+					{
+						bool ok = false;
+						const double weight = submitterParts[1].trimmed().toDouble(&ok);
+						if(ok && (weight > 0.0))
+						{
+							m_jobList->setSubmitterWeight(submitter, weight);
+						}
+					}
+				}
 				if((flags & IPC_FLAG_FORCE_START) && (!(flags & IPC_FLAG_FORCE_ENQUEUE))) runImmediately = true;
 				if((flags & IPC_FLAG_FORCE_ENQUEUE) && (!(flags & IPC_FLAG_FORCE_START))) runImmediately = false;
-				appendJob(args[0], args[1], &options, runImmediately);
+				appendJob(args[0], args[1], &options, runImmediately, priority, submitter);
 			}
 			else
 			{
@@ -1554,7 +1759,7 @@ bool MainWindow::createJobMultiple(const QStringList &filePathIn)
 	//Add files individually
 	for(iter = filePathIn.constBegin(); (iter != filePathIn.constEnd()) && (!applyToAll); iter++)
 	{
-		runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? m_preferences->getMaxRunningJobCount() : 1));
+		runImmediately = (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? getRunningJobLimit() : 1));
 		QString sourceFileName(*iter), outputFileName;
 		if(createJob(sourceFileName, outputFileName, m_options.data(), runImmediately, false, counter++, filePathIn.count(), &applyToAll))
 		{
@@ -1569,7 +1774,7 @@ bool MainWindow::createJobMultiple(const QStringList &filePathIn)
 	//Add remaining files
 	while(applyToAll && (iter != filePathIn.constEnd()))
 	{
-		const bool runImmediatelyTmp = runImmediately && (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? m_preferences->getMaxRunningJobCount() : 1));
+		const bool runImmediatelyTmp = runImmediately && (countRunningJobs() < (m_preferences->getAutoRunNextJob() ? getRunningJobLimit() : 1));
 		const QString sourceFileName = *iter;
 		const QString outputFileName = AddJobDialog::generateOutputFileName(sourceFileName, m_recentlyUsed->outputDirectory(), m_recentlyUsed->filterIndex(), m_preferences->getSaveToSourcePath());
 		if(!appendJob(sourceFileName, outputFileName, m_options.data(), runImmediatelyTmp))
@@ -1585,11 +1790,11 @@ bool MainWindow::createJobMultiple(const QStringList &filePathIn)
 /*
  * Append a new job
  */
-bool MainWindow::appendJob(const QString &sourceFileName, const QString &outputFileName, OptionsModel *options, const bool runImmediately)
+bool MainWindow::appendJob(const QString &sourceFileName, const QString &outputFileName, OptionsModel *options, const bool runImmediately, const int priority, const QString &submitter)
 {
 	bool okay = false;
 	EncodeThread *thrd = new EncodeThread(sourceFileName, outputFileName, options, m_sysinfo.data(), m_preferences.data());
-	QModelIndex newIndex = m_jobList->insertJob(thrd);
+	QModelIndex newIndex = m_jobList->insertJob(thrd, priority, submitter);
 
 	if(newIndex.isValid())
 	{
@@ -1597,7 +1802,7 @@ bool MainWindow::appendJob(const QString &sourceFileName, const QString &outputF
 		{
 			ui->jobsView->selectRow(newIndex.row());
 			QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-			m_jobList->startJob(newIndex);
+			startJob(newIndex);
 		}
 
 		okay = true;
@@ -1607,44 +1812,235 @@ bool MainWindow::appendJob(const QString &sourceFileName, const QString &outputF
 	return okay;
 }
 
+/*
+ * Start a job, along with the pending jobs that can share its source, as far as those fit into the remaining
+ * slots and into the available memory
+ */
+bool MainWindow::startJob(const QModelIndex &index)
+{
+	QList<QModelIndex> sharedJobs;
+	if((m_preferences->getSharedSourceJobs() > 0) && (m_jobList->getJobStatus(index) == JobStatus_Enqueued))
+	{
+		const bool memoryAdmission = m_preferences->getEnableMemoryAdmission();
+		const double maxSlots = static_cast<double>(getRunningJobLimit());
+		double runningSlots = countRunningSlots() + getJobSlots(index);
+		quint64 memoryHeadroom = 0;
+		if(memoryAdmission)
+		{
+			const quint64 available = getMemoryHeadroom(), required = getJobMemory(index);
+			memoryHeadroom = (available > required) ? (available - required) : 0;
+		}
+
+		const QList<QModelIndex> candidates = m_jobList->getSharedJobs(index);
+		for(QList<QModelIndex>::ConstIterator iter = candidates.constBegin(); iter != candidates.constEnd(); iter++)
+		{
+			if(checkAdmission(*iter, runningSlots, maxSlots, memoryAdmission, memoryHeadroom) == ADMISSION_START)
+			{
+				sharedJobs << (*iter);
+				runningSlots += getJobSlots(*iter);
+				memoryHeadroom -= memoryAdmission ? getJobMemory(*iter) : 0;
+			}
+		}
+	}
+
+	return m_jobList->startJob(index, getRunningJobLimit(), sharedJobs);
+}
+
 /*
  * Jobs that are not completed (or failed, or aborted) yet
  */
 unsigned int MainWindow::countPendingJobs(void)
 {
-	unsigned int count = 0;
-	const int rows = m_jobList->rowCount(QModelIndex());
+	return m_jobList->countPendingJobs();
+}
+
+/*
+ * Jobs that are still active, i.e. not terminated or enqueued
+ */
+unsigned int MainWindow::countRunningJobs(void)
+{
+	return m_jobList->countRunningJobs();
+}
+
+/*
+ * Count the slots occupied by the running jobs. The first pass of a multi-pass encode (with the default
+ * fast first pass settings) uses far fewer cores than the second pass, so it only occupies a fraction of
+ * a slot. This allows the first pass of another job to run alongside the second pass of a job.
+ */
+double MainWindow::countRunningSlots(void)
+{
+	const double firstPassLoad = static_cast<double>(m_preferences->getFirstPassLoad()) / 100.0;
+	const unsigned int firstPassJobs = m_jobList->countJobs(JobStatus_Running_Pass1);
+	return static_cast<double>(m_jobList->countRunningJobs() - firstPassJobs) + (static_cast<double>(firstPassJobs) * firstPassLoad);
+}
 
-	for(int i = 0; i < rows; i++)
+/*
+ * Count the running jobs that occupy a full slot, i.e. all jobs except for those in their first pass and
+ * those that are held before their second pass
+ */
+unsigned int MainWindow::countFullSlots(void)
+{
+	unsigned int heldJobs = 0;
+	for(QList<QUuid>::ConstIterator iter = m_heldJobs.constBegin(); iter != m_heldJobs.constEnd(); iter++)
 	{
-		JobStatus status = m_jobList->getJobStatus(m_jobList->index(i, 0, QModelIndex()));
-		if(status != JobStatus_Completed && status != JobStatus_Aborted && status != JobStatus_Failed)
+		const JobStatus status = m_jobList->getJobStatus(m_jobList->getJobIndexById(*iter));
+		if((status == JobStatus_Paused) || (status == JobStatus_Pausing))
 		{
-			count++;
+			heldJobs++;
 		}
 	}
 
-	return count;
+	return m_jobList->countRunningJobs() - m_jobList->countJobs(JobStatus_Running_Pass1) - heldJobs;
 }
 
 /*
- * Jobs that are still active, i.e. not terminated or enqueued
+ * Resume the job that has been held before its second pass for the longest time, as soon as it fits into
+ * the slots. Jobs that are still pausing are skipped, they are handled once they have become paused.
+ * Returns true, if a job has been resumed.
  */
-unsigned int MainWindow::countRunningJobs(void)
+bool MainWindow::resumeHeldJob(void)
 {
-	unsigned int count = 0;
-	const int rows = m_jobList->rowCount(QModelIndex());
+	QList<QUuid>::Iterator iter = m_heldJobs.begin();
+	while(iter != m_heldJobs.end())
+	{
+		const QModelIndex heldIndex = m_jobList->getJobIndexById(*iter);
+		const JobStatus status = m_jobList->getJobStatus(heldIndex);
+		if((status != JobStatus_Paused) && (status != JobStatus_Pausing))
+		{
+			iter = m_heldJobs.erase(iter); /*resumed by the user, aborted or deleted*/
+			continue;
+		}
+		if(status == JobStatus_Pausing)
+		{
+			iter++;
+			continue;
+		}
+		if(countFullSlots() >= getRunningJobLimit())
+		{
+			return false;
+		}
+		m_heldJobs.erase(iter);
+		return m_jobList->resumeJob(heldIndex);
+	}
 
-	for(int i = 0; i < rows; i++)
+	return false;
+}
+
+/*
+ * Check whether any of the held jobs has finished pausing, and thus is waiting for a full slot. Held jobs
+ * that are still pausing do not block new launches.
+ */
+bool MainWindow::hasPausedHeldJobs(void)
+{
+	for(QList<QUuid>::ConstIterator iter = m_heldJobs.constBegin(); iter != m_heldJobs.constEnd(); iter++)
+	{
+		if(m_jobList->getJobStatus(m_jobList->getJobIndexById(*iter)) == JobStatus_Paused)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * The number of jobs that may run at the same time, either fixed or as decided by the governor
+ */
+unsigned int MainWindow::getRunningJobLimit(void)
+{
+	return (!m_governor.isNull()) ? m_governor->getLimit() : m_preferences->getMaxRunningJobCount();
+}
+
+/*
+ * Memory that is available for another job. Jobs that are still starting up, or that have started encoding
+ * only recently, have not allocated their memory yet, so their predicted usage is subtracted in advance.
+ */
+quint64 MainWindow::getMemoryHeadroom(void)
+{
+	const quint64 available = MemoryModel::getAvailableMemory();
+	quint64 reserved = 0;
+
+	if((m_jobList->countJobs(JobStatus_Starting) + m_jobList->countJobs(JobStatus_Indexing)) > 0)
+	{
+		const QList<QUuid> &activeJobs = m_jobList->getActiveJobs();
+		for(QList<QUuid>::ConstIterator iter = activeJobs.constBegin(); iter != activeJobs.constEnd(); iter++)
+		{
+			const QModelIndex currentIndex = m_jobList->getJobIndexById(*iter);
+			const JobStatus status = m_jobList->getJobStatus(currentIndex);
+			if((status == JobStatus_Starting) || (status == JobStatus_Indexing))
+			{
+				reserved += getJobMemory(currentIndex);
+			}
+		}
+	}
+
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	QMap<QUuid, qint64>::Iterator iter = m_settlingJobs.begin();
+	while(iter != m_settlingJobs.end())
+	{
+		const QModelIndex currentIndex = m_jobList->getJobIndexById(iter.key());
+		const JobStatus status = m_jobList->getJobStatus(currentIndex);
+		if(((status != JobStatus_Running) && (status != JobStatus_Running_Pass1) && (status != JobStatus_Running_Pass2)) || ((now - iter.value()) > mem_settle))
+		{
+			iter = m_settlingJobs.erase(iter);
+			continue;
+		}
+		reserved += getJobMemory(currentIndex);
+		iter++;
+	}
+
+	return (available > reserved) ? (available - reserved) : 0;
+}
+
+/*
+ * Predicted peak memory usage of a job, based on the clip properties found by the look-ahead probe or,
+ * if there is no probe result, on the cached clip properties or the YUV4MPEG2 stream header
+ */
+quint64 MainWindow::getJobMemory(const QModelIndex &index)
+{
+	if(const OptionsModel *const options = m_jobList->getJobOptions(index))
+	{
+		ClipInfo clipInfo;
+		m_jobList->getJobClipInfo(index, clipInfo);
+		return MemoryModel::estimate(options, clipInfo);
+	}
+
+	return 0;
+}
+
+/*
+ * Check whether a pending job can be started now, given the remaining slots and the available memory
+ */
+MainWindow::admission_t MainWindow::checkAdmission(const QModelIndex &index, const double &runningSlots, const double &maxSlots, const bool &memoryAdmission, const quint64 &memoryHeadroom)
+{
+	if(runningSlots + getJobSlots(index) > maxSlots + 0.001)
+	{
+		qDebug("Next job does not fit into the remaining slots, won't launch it yet!");
+		return ADMISSION_STOP;
+	}
+	if(memoryAdmission && (getJobMemory(index) > memoryHeadroom))
+	{
+		//A smaller job further down the queue may still fit
+		qDebug("Next job does not fit into the available memory, trying the following one!");
+		return ADMISSION_DEFER;
+	}
+	return ADMISSION_START;
+}
+
+/*
+ * Slots that a pending job is going to occupy, once it has started
+ */
+double MainWindow::getJobSlots(const QModelIndex &index)
+{
+	if(const OptionsModel *const options = m_jobList->getJobOptions(index))
 	{
-		JobStatus status = m_jobList->getJobStatus(m_jobList->index(i, 0, QModelIndex()));
-		if(status != JobStatus_Completed && status != JobStatus_Aborted && status != JobStatus_Failed && status != JobStatus_Enqueued)
+		if(EncoderFactory::getEncoderInfo(options->encType()).rcModeToType(options->rcMode()) == AbstractEncoderInfo::RC_TYPE_MULTIPASS)
 		{
-			count++;
+			return static_cast<double>(m_preferences->getFirstPassLoad()) / 100.0;
 		}
 	}
 
-	return count;
+	return 1.0;
 }
 
 /*
@@ -1757,7 +2153,7 @@ bool MainWindow::parseCommandLineArgs(void)
 		foreach(const QString &options, args.values(CLI_PARAM_ADD_JOB))
 		{
 			const QStringList optionValues = options.split('|', QString::SkipEmptyParts);
-			if(optionValues.count() == 3)
+			if((optionValues.count() >= 3) && (optionValues.count() <= 5))
 			{
 				handleCommand(IPC_OPCODE_ADD_JOB, optionValues, flags);
 			}
@@ -26,6 +26,10 @@
 
 //Qt
 #include <QMainWindow>
+#include <QFutureSynchronizer>
+#include <QUuid>
+#include <QList>
+#include <QMap>
 
 //Forward declarations
 class JobListModel;
@@ -40,6 +44,7 @@ class QModelIndex;
 class QLabel;
 class QSystemTrayIcon;
 class IPCThread_Recv;
+class ConcurrencyGovernor;
 enum JobStatus;
 
 namespace Ui
@@ -81,6 +86,14 @@ private:
 	}
 	postOp_t;
 
+	typedef enum
+	{
+		ADMISSION_START = 0,
+		ADMISSION_DEFER = 1,
+		ADMISSION_STOP  = 2
+	}
+	admission_t;
+
 	Ui::MainWindow *const ui;
 	MUtils::IPCChannel *const m_ipcChannel;
 
@@ -90,6 +103,7 @@ private:
 	QScopedPointer<QLabel> m_label[2];
 	QScopedPointer<QMovie> m_animation;
 	QScopedPointer<QTimer> m_fileTimer;
+	QScopedPointer<QTimer> m_admissionTimer;
 
 	QScopedPointer<IPCThread_Recv>   m_ipcThread;
 	QScopedPointer<MUtils::Taskbar7> m_taskbar;
@@ -106,15 +120,30 @@ private:
 	QScopedPointer<SysinfoModel> m_sysinfo;
 	QScopedPointer<PreferencesModel> m_preferences;
 	QScopedPointer<RecentlyUsed> m_recentlyUsed;
+	QScopedPointer<ConcurrencyGovernor> m_governor;
+	QList<QUuid> m_heldJobs;
+	QMap<QUuid, qint64> m_settlingJobs;
+
+	QFutureSynchronizer<bool> m_revalidation;
 	
 	bool createJob(QString &sourceFileName, QString &outputFileName, OptionsModel *options, bool &runImmediately, const bool restart = false, int fileNo = -1, int fileTotal = 0, bool *applyToAll = NULL);
 	bool createJobMultiple(const QStringList &filePathIn);
 
-	bool appendJob(const QString &sourceFileName, const QString &outputFileName, OptionsModel *options, const bool runImmediately);
+	bool appendJob(const QString &sourceFileName, const QString &outputFileName, OptionsModel *options, const bool runImmediately, const int priority = 0, const QString &submitter = QString());
+	bool startJob(const QModelIndex &index);
 	void updateButtons(JobStatus status);
 	void updateTaskbar(JobStatus status, const QIcon &icon);
 	unsigned int countPendingJobs(void);
 	unsigned int countRunningJobs(void);
+	double countRunningSlots(void);
+	unsigned int countFullSlots(void);
+	bool resumeHeldJob(void);
+	bool hasPausedHeldJobs(void);
+	unsigned int getRunningJobLimit(void);
+	quint64 getMemoryHeadroom(void);
+	quint64 getJobMemory(const QModelIndex &index);
+	double getJobSlots(const QModelIndex &index);
+	admission_t checkAdmission(const QModelIndex &index, const double &runningSlots, const double &maxSlots, const bool &memoryAdmission, const quint64 &memoryHeadroom);
 
 	bool parseCommandLineArgs(void);
 
@@ -135,6 +164,7 @@ private slots:
 	void handleCommand(const int &command, const QStringList &args, const quint32 &flags = 0);
 	void jobSelected(const QModelIndex &current, const QModelIndex &previous);
 	void jobChangedData(const  QModelIndex &top, const  QModelIndex &bottom);
+	void jobStatusChanged(const QModelIndex &index, const JobStatus &newStatus);
 	void jobLogExtended(const QModelIndex & parent, int start, int end);
 	void jobListKeyPressed(const int &tag);
 	void launchNextJob();
@@ -25,6 +25,7 @@
 //Internal
 #include "global.h"
 #include "model_sysinfo.h"
+#include "binary_manifest.h"
 
 //MUtils
 #include <MUtils/UpdateChecker.h>
@@ -549,6 +550,7 @@ bool UpdaterDialog::checkBinaries(void)
 			}
 		}
 	}
+	BinaryManifest::save();
 	qDebug("File check completed.\n");
 	return true;
 }
@@ -556,12 +558,18 @@ bool UpdaterDialog::checkBinaries(void)
 bool UpdaterDialog::checkFileHash(const QString &filePath, const char *expectedHash)
 {
 	qDebug("Checking file: %s", MUTILS_UTF8(filePath));
-	QScopedPointer<MUtils::Hash::Hash> checksum(MUtils::Hash::create(MUtils::Hash::HASH_BLAKE2_512, DIGEST_KEY));
 	QFile file(filePath);
 	if(file.open(QIODevice::ReadOnly))
 	{
-		checksum->update(file);
-		const QByteArray fileHash = checksum->digest();
+		//Don't hash the file again, if size and time stamp are unchanged since the digest was computed
+		QByteArray fileHash;
+		if(!BinaryManifest::lookupDigest(filePath, fileHash))
+		{
+			QScopedPointer<MUtils::Hash::Hash> checksum(MUtils::Hash::create(MUtils::Hash::HASH_BLAKE2_512, DIGEST_KEY));
+			checksum->update(file);
+			fileHash = checksum->digest();
+			BinaryManifest::insertDigest(filePath, fileHash);
+		}
 		if((strlen(expectedHash) != fileHash.size()) || (memcmp(fileHash.constData(), expectedHash, fileHash.size()) != 0))
 		{
 			qWarning("\nFile appears to be corrupted:\n%s\n", filePath.toUtf8().constData());